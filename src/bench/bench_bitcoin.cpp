@@ -4,6 +4,7 @@
 
 #include <bench/bench.h>
 
+#include <crypto/neoscrypt.h>
 #include <crypto/sha256.h>
 #include <key.h>
 #include <random.h>
@@ -65,6 +66,8 @@ int main(int argc, char** argv)
     const fs::path bench_datadir{SetDataDir()};
 
     SHA256AutoDetect();
+    neoscrypt_autodetect();
+    InitPoWCache();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
@@ -7,12 +7,20 @@
 #include <chainparams.h>
 #include <validation.h>
 #include <streams.h>
+#include <consensus/merkle.h>
 #include <consensus/validation.h>
+#include <miner.h>
+#include <pow.h>
+#include <util.h>
+
+#include <boost/thread/thread.hpp>
 
 namespace block_bench {
 #include <bench/data/block413567.raw.h>
 } // namespace block_bench
 
+static const int MIN_CORES = 2;
+
 // These are the two major time-sinks which happen after we have fully received
 // a block off the wire, but before we can relay the block on to peers using
 // compact block relay.
@@ -47,10 +55,101 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
         stream >> block;
         assert(stream.Rewind(sizeof(block_bench::block413567)));
 
+        // This is a Bitcoin block, its proof of work only holds for SHA256d
         CValidationState validationState;
-        assert(CheckBlock(block, validationState, chainParams->GetConsensus()));
+        assert(CheckBlock(block, validationState, chainParams->GetConsensus(), false));
+    }
+}
+
+// A chain of minimal blocks on top of the genesis block, one second apart
+// starting at nTimeFirst.
+static std::vector<CBlock> CreateHeaderRun(const Consensus::Params& params, int nHeaders, int64_t nTimeFirst)
+{
+    std::vector<CBlock> blocks;
+    uint256 hashPrevBlock = params.hashGenesisBlock;
+    for (int i = 0; i < nHeaders; i++) {
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vin[0].scriptSig = CScript() << (i + 1) << OP_0;
+        coinbase.vout.resize(1);
+        coinbase.vout[0].nValue = 50 * COIN;
+        coinbase.vout[0].scriptPubKey = CScript() << OP_TRUE;
+
+        CBlock block;
+        block.nVersion = 4;
+        block.hashPrevBlock = hashPrevBlock;
+        block.nTime = nTimeFirst + i;
+        block.nBits = UintToArith256(params.powLimit).GetCompact();
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+
+        uint64_t nMaxTries = std::numeric_limits<uint64_t>::max();
+        assert(SolveBlockHeader(&block, std::numeric_limits<uint32_t>::max(), nMaxTries, 1, params));
+        hashPrevBlock = block.GetHash();
+        blocks.push_back(block);
     }
+    return blocks;
+}
+
+static void GetPoWHashTest(benchmark::State& state)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::TESTNET);
+    const Consensus::Params& consensusParams = chainParams->GetConsensus();
+    // Straddle the NeoScrypt fork, so that both the Scrypt and the NeoScrypt profile get exercised
+    const std::vector<CBlock> blocks = CreateHeaderRun(consensusParams, 2, consensusParams.nNeoScryptFork - 1);
+
+    while (state.KeepRunning()) {
+        for (const CBlock& block : blocks) {
+            block.GetPoWHash(GetPoWProfile(block, consensusParams));
+        }
+    }
+}
+
+// Header sync followed by the blocks: a run of headers accepted through
+// ProcessNewBlockHeaders, which hashes their proof of work in batches on the
+// PoW check threads, then the context-free checks of the full blocks, which
+// find that proof of work in the cache.
+static void CheckBlockHeadersTest(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::TESTNET);
+    const CChainParams& chainparams = Params();
+    const Consensus::Params& consensusParams = chainparams.GetConsensus();
+
+    // The testnet genesis block is just before the NeoScrypt fork
+    std::vector<CBlock> blocks = CreateHeaderRun(consensusParams, 64, consensusParams.nNeoScryptFork);
+    std::vector<CBlockHeader> headers;
+    for (const CBlock& block : blocks)
+        headers.push_back(block.GetBlockHeader());
+
+    boost::thread_group threadGroup;
+    nScriptCheckThreads = std::max(MIN_CORES, GetNumCores());
+    for (int i = 0; i < nScriptCheckThreads - 1; i++)
+        threadGroup.create_thread(&ThreadPoWCheck);
+
+    while (state.KeepRunning()) {
+        // Start over from an index holding just the genesis block, so that
+        // the headers are new every time. Headers unknown to the index get
+        // hashed whatever the cache holds.
+        UnloadBlockIndex();
+        assert(LoadGenesisBlock(chainparams));
+
+        CValidationState validationState;
+        assert(ProcessNewBlockHeaders(headers, validationState, chainparams));
+
+        for (CBlock& block : blocks) {
+            block.fChecked = false;
+            assert(CheckBlock(block, validationState, consensusParams));
+        }
+    }
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+    nScriptCheckThreads = 0;
+    UnloadBlockIndex();
 }
 
 BENCHMARK(DeserializeBlockTest, 130);
 BENCHMARK(DeserializeAndCheckBlockTest, 160);
+BENCHMARK(GetPoWHashTest, 700);
+BENCHMARK(CheckBlockHeadersTest, 22);
@@ -10,6 +10,7 @@
 #include <random.h>
 #include <uint256.h>
 #include <utiltime.h>
+#include <crypto/neoscrypt.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
@@ -68,6 +69,48 @@ static void SHA512(benchmark::State& state)
         CSHA512().Write(in.data(), in.size()).Finalize(hash);
 }
 
+static void NeoScrypt(benchmark::State& state, unsigned int profile)
+{
+    std::vector<uint8_t> in(80, 0), out(32);
+    while (state.KeepRunning()) {
+        neoscrypt(in.data(), out.data(), profile);
+        in[0] = out[0];
+    }
+}
+
+/* As many headers as the widest lane kernel hashes at once */
+static void NeoScrypt_8way(benchmark::State& state, unsigned int profile)
+{
+    std::vector<uint8_t> in(80 * 8, 0), out(32 * 8);
+    while (state.KeepRunning()) {
+        neoscrypt_N_way(in.data(), out.data(), profile, 8);
+        in[0] = out[0];
+    }
+}
+
+static void NeoScrypt_0x0(benchmark::State& state) { NeoScrypt(state, 0x0); }
+static void NeoScrypt_0x3(benchmark::State& state) { NeoScrypt(state, 0x3); }
+static void NeoScrypt_0x0_8way(benchmark::State& state) { NeoScrypt_8way(state, 0x0); }
+static void NeoScrypt_0x3_8way(benchmark::State& state) { NeoScrypt_8way(state, 0x3); }
+
+/* The key derivation run before and after the NeoScrypt mixing */
+static void NeoScrypt_FastKDF(benchmark::State& state)
+{
+    std::vector<uint8_t> in(80, 0), out(256);
+    while (state.KeepRunning()) {
+        neoscrypt_fastkdf(in.data(), in.size(), in.data(), in.size(), 32, out.data(), out.size());
+        in[0] = out[0];
+    }
+}
+
+static void NeoScrypt_BLAKE2s(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64, 0), key(32, 0);
+    while (state.KeepRunning()) {
+        neoscrypt_blake2s(in.data(), in.size(), key.data(), key.size(), in.data(), 32);
+    }
+}
+
 static void SipHash_32b(benchmark::State& state)
 {
     uint256 x;
@@ -103,5 +146,11 @@ BENCHMARK(SHA512, 330);
 BENCHMARK(SHA256_32b, 4700 * 1000);
 BENCHMARK(SipHash_32b, 40 * 1000 * 1000);
 BENCHMARK(SHA256D64_1024, 7400);
+BENCHMARK(NeoScrypt_0x0, 1400);
+BENCHMARK(NeoScrypt_0x3, 1600);
+BENCHMARK(NeoScrypt_0x0_8way, 550);
+BENCHMARK(NeoScrypt_0x3_8way, 500);
+BENCHMARK(NeoScrypt_FastKDF, 37 * 1000);
+BENCHMARK(NeoScrypt_BLAKE2s, 1300 * 1000);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -32,6 +32,12 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(WIN32)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
 #include <crypto/neoscrypt.h>
 
 /* SHA-256 */
@@ -1957,8 +1963,6 @@ void neoscrypt_blake2s(const void *input, const unsigned int input_size,
     neoscrypt_copy(output, S, output_size);
 }
 
-#ifndef OPT
-
 #define FASTKDF_BUFFER_SIZE 256U
 
 /* FastKDF, a fast buffered key derivation function:
@@ -2053,7 +2057,7 @@ void neoscrypt_fastkdf(const unsigned char *password, unsigned int password_len,
 
 }
 
-#else
+#ifdef OPT
 
 /* Initialisation vector with a parameter block XOR'ed in */
 static const unsigned int blake2s_IV_P_XOR[8] = {
@@ -2145,7 +2149,7 @@ void neoscrypt_fastkdf_opt(const unsigned char *password, const unsigned char *s
     }
 }
 
-#endif /* !(OPT) */
+#endif /* OPT */
 
 
 /* Configurable optimised block mixer */
@@ -2220,6 +2224,79 @@ static void neoscrypt_blkmix(unsigned int *X, unsigned int *Y, unsigned int r, u
 }
 
 
+/* Scratchpad management */
+
+void neoscrypt_ctx_init(neoscrypt_ctx *ctx, unsigned int flags) {
+    ctx->scratchpad = NULL;
+    ctx->size = 0;
+    ctx->mapped = 0;
+    ctx->flags = flags;
+}
+
+void neoscrypt_ctx_free(neoscrypt_ctx *ctx) {
+
+    if(ctx->scratchpad) {
+#if defined(MAP_HUGETLB)
+        if(ctx->mapped)
+          munmap(ctx->scratchpad, ctx->size);
+        else
+#endif
+#if defined(WIN32)
+          _aligned_free(ctx->scratchpad);
+#else
+          free(ctx->scratchpad);
+#endif
+    }
+
+    ctx->scratchpad = NULL;
+    ctx->size = 0;
+    ctx->mapped = 0;
+}
+
+/* Grows the scratchpad to at least size bytes, 64-byte aligned;
+ * the previous contents are not preserved */
+int neoscrypt_ctx_reserve(neoscrypt_ctx *ctx, size_t size) {
+    const size_t align = 0x40;
+    void *p = NULL;
+
+    if(size <= ctx->size)
+      return(0);
+
+    neoscrypt_ctx_free(ctx);
+
+#if defined(MAP_HUGETLB)
+    /* Falls back to regular pages if none are reserved by the system */
+    if(ctx->flags & NEOSCRYPT_CTX_HUGEPAGES) {
+        const size_t page = NEOSCRYPT_HUGEPAGE_SIZE;
+        size_t len = (size + page - 1) & ~(page - 1);
+
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(p != MAP_FAILED) {
+            ctx->scratchpad = (unsigned char *) p;
+            ctx->size = len;
+            ctx->mapped = 1;
+            return(0);
+        }
+        p = NULL;
+    }
+#endif
+
+#if defined(WIN32)
+    p = _aligned_malloc(size, align);
+#else
+    if(posix_memalign(&p, align, size))
+      p = NULL;
+#endif
+    if(!p)
+      return(-1);
+
+    ctx->scratchpad = (unsigned char *) p;
+    ctx->size = size;
+    return(0);
+}
+
+
 /* NeoScrypt core engine:
  * p = 1, salt = password;
  * Basic customisation (required):
@@ -2251,8 +2328,8 @@ static void neoscrypt_blkmix(unsigned int *X, unsigned int *Y, unsigned int r, u
  *     .....
  *     11110 = N of 2147483648;
  *   profile bits 30 to 13 are reserved */
-void neoscrypt(const unsigned char *password, unsigned char *output, unsigned int profile) {
-    const size_t stack_align = 0x40;
+int neoscrypt_ctx_hash(neoscrypt_ctx *ctx, const unsigned char *password,
+  unsigned char *output, unsigned int profile) {
     unsigned int N = 128, r = 2, dblmix = 1, mixmode = 0x14;
     unsigned int kdf, i, j;
     unsigned int *X, *Y, *Z, *V;
@@ -2269,9 +2346,10 @@ void neoscrypt(const unsigned char *password, unsigned char *output, unsigned in
         r = (1 << ((profile >> 5) & 0x7));
     }
 
-    unsigned char stack[(N + 3) * r * 2 * BLOCK_SIZE + stack_align];
+    if(neoscrypt_ctx_reserve(ctx, (size_t)(N + 3) * r * 2 * BLOCK_SIZE))
+      return(-1);
     /* X = r * 2 * BLOCK_SIZE */
-    X = (unsigned int *) (((size_t)stack & ~(stack_align - 1)) + stack_align);
+    X = (unsigned int *) ctx->scratchpad;
     /* Z is a copy of X for ChaCha */
     Z = &X[32 * r];
     /* Y is an X sized temporal space */
@@ -2365,4 +2443,12 @@ void neoscrypt(const unsigned char *password, unsigned char *output, unsigned in
 
     }
 
+    return(0);
+}
+
+void neoscrypt(const unsigned char *password, unsigned char *output, unsigned int profile) {
+
+    /* Out of memory for the scratchpad, nothing sensible to return */
+    if(neoscrypt_ctx_hash(neoscrypt_thread_ctx(), password, output, profile))
+      abort();
 }
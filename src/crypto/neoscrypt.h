@@ -1,10 +1,63 @@
+#ifndef BITCOIN_CRYPTO_NEOSCRYPT_H
+#define BITCOIN_CRYPTO_NEOSCRYPT_H
+
+#include <stddef.h>
+
 #if (__cplusplus)
 extern "C" {
 #endif
 
+/* Back the scratchpad with huge pages where the system provides them */
+#define NEOSCRYPT_CTX_HUGEPAGES 0x1
+
+#define NEOSCRYPT_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/* Reusable hashing context owning a 64-byte aligned heap scratchpad,
+ * grown on demand; a context must not be shared between threads */
+typedef struct neoscrypt_ctx_t {
+    unsigned char *scratchpad;
+    size_t size;
+    unsigned int mapped;
+    unsigned int flags;
+} neoscrypt_ctx;
+
+void neoscrypt_ctx_init(neoscrypt_ctx *ctx, unsigned int flags);
+void neoscrypt_ctx_free(neoscrypt_ctx *ctx);
+int neoscrypt_ctx_reserve(neoscrypt_ctx *ctx, size_t size);
+
+/* Returns 0 on success or -1 if the scratchpad cannot be allocated */
+int neoscrypt_ctx_hash(neoscrypt_ctx *ctx, const unsigned char *password,
+  unsigned char *output, unsigned int profile);
+
+/* The calling thread's context, created on first use and released
+ * when the thread exits */
+neoscrypt_ctx *neoscrypt_thread_ctx(void);
+
+/* Flags for thread contexts created from now on */
+void neoscrypt_thread_ctx_flags(unsigned int flags);
+
+/* Hashes through the calling thread's context */
 void neoscrypt(const unsigned char *password, unsigned char *output,
   unsigned int profile);
 
+/* Hashes n 80-byte inputs stored back to back into n 32-byte outputs;
+ * full groups of inputs are processed by the multi-lane SIMD kernels
+ * selected by neoscrypt_autodetect(), the rest by neoscrypt() */
+void neoscrypt_N_way(const unsigned char *input, unsigned char *output,
+  unsigned int profile, unsigned int n);
+
+/* Selects the widest multi-lane kernels supported by the CPU and
+ * returns a description of them */
+const char *neoscrypt_autodetect(void);
+
+void neoscrypt_fastkdf(const unsigned char *password, unsigned int password_len,
+  const unsigned char *salt, unsigned int salt_len, unsigned int N,
+  unsigned char *output, unsigned int output_len);
+
+void neoscrypt_pbkdf2_sha256(const unsigned char *password, unsigned int password_len,
+  const unsigned char *salt, unsigned int salt_len, unsigned int N,
+  unsigned char *output, unsigned int output_len);
+
 void neoscrypt_blake2s(const void *input, const unsigned int input_size,
   const void *key, const unsigned char key_size,
   void *output, const unsigned char output_size);
@@ -45,4 +98,6 @@ typedef unsigned char hash_digest[DIGEST_SIZE];
     U32TO8_BE((p),     (unsigned int)((v) >> 32)); \
     U32TO8_BE((p) + 4, (unsigned int)((v)      ));
 
-#endif
\ No newline at end of file
+#endif
+
+#endif // BITCOIN_CRYPTO_NEOSCRYPT_H
@@ -0,0 +1,37 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <crypto/neoscrypt_lanes.h>
+
+namespace neoscrypt_avx2 {
+namespace {
+
+/** Eight lanes, one per 32-bit element of an AVX2 register. */
+struct AVX2
+{
+    typedef __m256i Word;
+    static const unsigned int LANES = 8;
+
+    static inline Word Load(const uint32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static inline void Store(uint32_t* p, Word v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static inline Word Add(Word x, Word y) { return _mm256_add_epi32(x, y); }
+    static inline Word Xor(Word x, Word y) { return _mm256_xor_si256(x, y); }
+    static inline Word RotL(Word x, int n) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+};
+
+} // namespace
+
+void Hash_8way(const unsigned char* in, unsigned char* out, unsigned int profile, neoscrypt_ctx* ctx)
+{
+    neoscrypt_lanes::Lanes<AVX2>::Hash(in, out, profile, ctx);
+}
+
+} // namespace neoscrypt_avx2
+
+#endif
@@ -0,0 +1,174 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/neoscrypt.h>
+#include <crypto/common.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <atomic>
+#include <new>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#if defined(USE_ASM)
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__x86_64__) || defined(__amd64__)
+namespace neoscrypt_sse2
+{
+void Hash_4way(const unsigned char* in, unsigned char* out, unsigned int profile, neoscrypt_ctx* ctx);
+}
+#endif
+
+namespace neoscrypt_avx2
+{
+void Hash_8way(const unsigned char* in, unsigned char* out, unsigned int profile, neoscrypt_ctx* ctx);
+}
+
+// Internal implementation code.
+namespace
+{
+typedef void (*HashNWayType)(const unsigned char*, unsigned char*, unsigned int, neoscrypt_ctx*);
+
+HashNWayType Hash_4way = nullptr;
+HashNWayType Hash_8way = nullptr;
+
+std::atomic<unsigned int> g_thread_ctx_flags{0};
+
+/** Owns a thread's scratchpad until the thread exits. */
+class ThreadContext
+{
+public:
+    neoscrypt_ctx ctx;
+
+    ThreadContext() { neoscrypt_ctx_init(&ctx, g_thread_ctx_flags.load()); }
+    ~ThreadContext() { neoscrypt_ctx_free(&ctx); }
+
+    ThreadContext(const ThreadContext&) = delete;
+    ThreadContext& operator=(const ThreadContext&) = delete;
+};
+
+/** Compare the selected multi-lane kernels against the scalar reference. */
+bool SelfTest()
+{
+    static const unsigned int profiles[2] = {0x0, 0x3};
+    unsigned char in[8 * 80];
+    unsigned char out[8 * 32], ref[8 * 32];
+    neoscrypt_ctx* ctx = neoscrypt_thread_ctx();
+
+    for (unsigned int i = 0; i < sizeof(in); ++i) in[i] = (unsigned char)(i * 7 + 1);
+
+    for (unsigned int profile : profiles) {
+        for (unsigned int i = 0; i < 8; ++i) neoscrypt(in + 80 * i, ref + 32 * i, profile);
+
+        if (Hash_4way) {
+            Hash_4way(in, out, profile, ctx);
+            if (memcmp(out, ref, 4 * 32)) return false;
+        }
+
+        if (Hash_8way) {
+            Hash_8way(in, out, profile, ctx);
+            if (memcmp(out, ref, 8 * 32)) return false;
+        }
+    }
+
+    return true;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+// We can't use cpuid.h's __get_cpuid as it does not support subleafs.
+void inline cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d)
+{
+#ifdef __GNUC__
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+#else
+  __asm__ ("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(leaf), "2"(subleaf));
+#endif
+}
+
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+} // namespace
+
+extern "C" neoscrypt_ctx *neoscrypt_thread_ctx(void)
+{
+    static thread_local ThreadContext context;
+    return &context.ctx;
+}
+
+extern "C" void neoscrypt_thread_ctx_flags(unsigned int flags)
+{
+    g_thread_ctx_flags = flags;
+}
+
+extern "C" const char *neoscrypt_autodetect(void)
+{
+    const char* ret = "standard";
+
+#if defined(__x86_64__) || defined(__amd64__)
+    // SSE2 is part of the x86_64 baseline, no need to ask the CPU.
+    Hash_4way = neoscrypt_sse2::Hash_4way;
+    ret = "sse2(4way)";
+#endif
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    bool have_xsave = false;
+    bool have_avx = false;
+    bool have_avx2 = false;
+    bool enabled_avx = false;
+
+    (void)AVXEnabled;
+    (void)have_avx2;
+    (void)enabled_avx;
+
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, eax, ebx, ecx, edx);
+    have_xsave = (ecx >> 27) & 1;
+    have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        enabled_avx = AVXEnabled();
+        cpuid(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2 && enabled_avx) {
+        Hash_8way = neoscrypt_avx2::Hash_8way;
+        ret = "sse2(4way),avx2(8way)";
+    }
+#endif
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
+
+extern "C" void neoscrypt_N_way(const unsigned char *input, unsigned char *output,
+  unsigned int profile, unsigned int n)
+{
+    neoscrypt_ctx* ctx = neoscrypt_thread_ctx();
+
+    // The lane kernels only implement the standard profiles; extended
+    // customisation (bit 31) always goes through the scalar code.
+    if (!(profile >> 31)) {
+        if (Hash_8way) {
+            for (; n >= 8; n -= 8, input += 8 * 80, output += 8 * 32) Hash_8way(input, output, profile, ctx);
+        }
+        if (Hash_4way) {
+            for (; n >= 4; n -= 4, input += 4 * 80, output += 4 * 32) Hash_4way(input, output, profile, ctx);
+        }
+    }
+    for (; n > 0; --n, input += 80, output += 32) {
+        if (neoscrypt_ctx_hash(ctx, input, output, profile)) throw std::bad_alloc();
+    }
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_NEOSCRYPT_LANES_H
+#define BITCOIN_CRYPTO_NEOSCRYPT_LANES_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <new>
+
+#include <crypto/neoscrypt.h>
+
+/* Several NeoScrypt/Scrypt hashes computed side by side: word i of every lane
+ * lives in one vector register, so each Salsa/ChaCha round advances all lanes
+ * at once. Only the standard profiles (r = 1 or 2) are supported.
+ *
+ * The driver is shared between the instruction sets; each of them includes
+ * this from the translation unit built with its compiler flags and passes a
+ * traits class providing the vector type Word, the lane count LANES and the
+ * Load, Store, Add, Xor and RotL kernels. */
+
+namespace neoscrypt_lanes {
+
+template <typename ISA>
+class Lanes
+{
+private:
+    typedef typename ISA::Word Word;
+    static const unsigned int LANES = ISA::LANES;
+
+    static inline void SalsaQuarter(Word& a, Word& b, Word& c, Word& d)
+    {
+        b = ISA::Xor(b, ISA::RotL(ISA::Add(a, d), 7));
+        c = ISA::Xor(c, ISA::RotL(ISA::Add(b, a), 9));
+        d = ISA::Xor(d, ISA::RotL(ISA::Add(c, b), 13));
+        a = ISA::Xor(a, ISA::RotL(ISA::Add(d, c), 18));
+    }
+
+    static inline void ChaChaQuarter(Word& a, Word& b, Word& c, Word& d)
+    {
+        a = ISA::Add(a, b); d = ISA::RotL(ISA::Xor(d, a), 16);
+        c = ISA::Add(c, d); b = ISA::RotL(ISA::Xor(b, c), 12);
+        a = ISA::Add(a, b); d = ISA::RotL(ISA::Xor(d, a), 8);
+        c = ISA::Add(c, d); b = ISA::RotL(ISA::Xor(b, c), 7);
+    }
+
+    /** Salsa20 or ChaCha20 core over one interleaved 64-byte block per lane. */
+    static void Mix(uint32_t* B, unsigned int rounds, bool chacha)
+    {
+        Word x[16];
+        for (int k = 0; k < 16; ++k) x[k] = ISA::Load(B + k * LANES);
+
+        if (chacha) {
+            for (; rounds; rounds -= 2) {
+                ChaChaQuarter(x[0], x[4], x[8], x[12]);
+                ChaChaQuarter(x[1], x[5], x[9], x[13]);
+                ChaChaQuarter(x[2], x[6], x[10], x[14]);
+                ChaChaQuarter(x[3], x[7], x[11], x[15]);
+                ChaChaQuarter(x[0], x[5], x[10], x[15]);
+                ChaChaQuarter(x[1], x[6], x[11], x[12]);
+                ChaChaQuarter(x[2], x[7], x[8], x[13]);
+                ChaChaQuarter(x[3], x[4], x[9], x[14]);
+            }
+        } else {
+            for (; rounds; rounds -= 2) {
+                SalsaQuarter(x[0], x[4], x[8], x[12]);
+                SalsaQuarter(x[5], x[9], x[13], x[1]);
+                SalsaQuarter(x[10], x[14], x[2], x[6]);
+                SalsaQuarter(x[15], x[3], x[7], x[11]);
+                SalsaQuarter(x[0], x[1], x[2], x[3]);
+                SalsaQuarter(x[5], x[6], x[7], x[4]);
+                SalsaQuarter(x[10], x[11], x[8], x[9]);
+                SalsaQuarter(x[15], x[12], x[13], x[14]);
+            }
+        }
+
+        for (int k = 0; k < 16; ++k) ISA::Store(B + k * LANES, ISA::Add(ISA::Load(B + k * LANES), x[k]));
+    }
+
+    static inline void BlkXor(uint32_t* dst, const uint32_t* src, unsigned int words)
+    {
+        for (unsigned int k = 0; k < words; ++k) ISA::Store(dst + k * LANES, ISA::Xor(ISA::Load(dst + k * LANES), ISA::Load(src + k * LANES)));
+    }
+
+    static inline void BlkSwp(uint32_t* a, uint32_t* b, unsigned int words)
+    {
+        for (unsigned int k = 0; k < words; ++k) {
+            Word t = ISA::Load(a + k * LANES);
+            ISA::Store(a + k * LANES, ISA::Load(b + k * LANES));
+            ISA::Store(b + k * LANES, t);
+        }
+    }
+
+    /** Lane-parallel equivalent of neoscrypt_blkmix() for r of 1 or 2. */
+    static void BlkMix(uint32_t* X, unsigned int r, unsigned int rounds, bool chacha)
+    {
+        const unsigned int blk = 16 * LANES;
+        if (r == 1) {
+            BlkXor(&X[0], &X[blk], 16);
+            Mix(&X[0], rounds, chacha);
+            BlkXor(&X[blk], &X[0], 16);
+            Mix(&X[blk], rounds, chacha);
+            return;
+        }
+        BlkXor(&X[0], &X[3 * blk], 16);
+        Mix(&X[0], rounds, chacha);
+        BlkXor(&X[blk], &X[0], 16);
+        Mix(&X[blk], rounds, chacha);
+        BlkXor(&X[2 * blk], &X[blk], 16);
+        Mix(&X[2 * blk], rounds, chacha);
+        BlkXor(&X[3 * blk], &X[2 * blk], 16);
+        Mix(&X[3 * blk], rounds, chacha);
+        BlkSwp(&X[blk], &X[2 * blk], 16);
+    }
+
+    static void SMix(uint32_t* X, uint32_t* V, unsigned int N, unsigned int r, unsigned int rounds, bool chacha)
+    {
+        const unsigned int words = 32 * r;
+        for (unsigned int i = 0; i < N; ++i) {
+            memcpy(&V[i * words * LANES], X, words * LANES * sizeof(uint32_t));
+            BlkMix(X, r, rounds, chacha);
+        }
+        for (unsigned int i = 0; i < N; ++i) {
+            // Integerify differs per lane, so the lookup into V is done lane by lane
+            for (unsigned int l = 0; l < LANES; ++l) {
+                const unsigned int j = X[16 * (2 * r - 1) * LANES + l] & (N - 1);
+                const uint32_t* v = &V[j * words * LANES + l];
+                for (unsigned int w = 0; w < words; ++w) X[w * LANES + l] ^= v[w * LANES];
+            }
+            BlkMix(X, r, rounds, chacha);
+        }
+    }
+
+    static void KDF(unsigned int kdf, const unsigned char* password, const unsigned char* salt, unsigned int salt_len, unsigned char* output, unsigned int output_len)
+    {
+        if (kdf == 0x1) {
+            neoscrypt_pbkdf2_sha256(password, 80, salt, salt_len, 1, output, output_len);
+        } else {
+            neoscrypt_fastkdf(password, 80, salt, salt_len, 32, output, output_len);
+        }
+    }
+
+public:
+    /** Hash LANES consecutive 80-byte inputs into LANES consecutive 32-byte outputs. */
+    static void Hash(const unsigned char* in, unsigned char* out, unsigned int profile, neoscrypt_ctx* ctx)
+    {
+        unsigned int N = 128, r = 2, rounds = 20;
+        bool dblmix = true;
+        if (profile & 0x1) {
+            N = 1024;
+            r = 1;
+            rounds = 8;
+            dblmix = false;
+        }
+        const unsigned int kdf = (profile >> 1) & 0xF;
+        const unsigned int words = 32 * r;
+
+        // V, X and Z are carved out of the caller's reusable scratchpad
+        if (neoscrypt_ctx_reserve(ctx, (N + 2) * words * LANES * sizeof(uint32_t))) throw std::bad_alloc();
+        uint32_t* V = (uint32_t*)ctx->scratchpad;
+        uint32_t* X = V + N * words * LANES;
+        uint32_t* Z = X + words * LANES;
+        uint32_t lane[64];
+
+        for (unsigned int l = 0; l < LANES; ++l) {
+            KDF(kdf, in + 80 * l, in + 80 * l, 80, (unsigned char*)lane, words * 4);
+            for (unsigned int w = 0; w < words; ++w) X[w * LANES + l] = lane[w];
+        }
+
+        if (dblmix) {
+            memcpy(Z, X, words * LANES * sizeof(uint32_t));
+            SMix(Z, V, N, r, rounds, true);
+        }
+        SMix(X, V, N, r, rounds, false);
+        if (dblmix) BlkXor(X, Z, words);
+
+        for (unsigned int l = 0; l < LANES; ++l) {
+            for (unsigned int w = 0; w < words; ++w) lane[w] = X[w * LANES + l];
+            KDF(kdf, in + 80 * l, (const unsigned char*)lane, words * 4, out + 32 * l, 32);
+        }
+    }
+};
+
+} // namespace neoscrypt_lanes
+
+#endif // BITCOIN_CRYPTO_NEOSCRYPT_LANES_H
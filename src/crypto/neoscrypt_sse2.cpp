@@ -0,0 +1,37 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(__x86_64__) || defined(__amd64__)
+
+#include <stdint.h>
+#include <emmintrin.h>
+
+#include <crypto/neoscrypt_lanes.h>
+
+namespace neoscrypt_sse2 {
+namespace {
+
+/** Four lanes, one per 32-bit element of an SSE2 register. */
+struct SSE2
+{
+    typedef __m128i Word;
+    static const unsigned int LANES = 4;
+
+    static inline Word Load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static inline void Store(uint32_t* p, Word v) { _mm_storeu_si128((__m128i*)p, v); }
+    static inline Word Add(Word x, Word y) { return _mm_add_epi32(x, y); }
+    static inline Word Xor(Word x, Word y) { return _mm_xor_si128(x, y); }
+    static inline Word RotL(Word x, int n) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n)); }
+};
+
+} // namespace
+
+void Hash_4way(const unsigned char* in, unsigned char* out, unsigned int profile, neoscrypt_ctx* ctx)
+{
+    neoscrypt_lanes::Lanes<SSE2>::Hash(in, out, profile, ctx);
+}
+
+} // namespace neoscrypt_sse2
+
+#endif
@@ -7,15 +7,19 @@
 
 #include "chainparams.h"
 #include "clientversion.h"
+#include "fs.h"
 #include "hash.h"
 #include "streams.h"
 #include "util.h"
 
-#include <boost/filesystem.hpp>
-
 /** 
 *   Generic Dumping and Loading
 *   ---------------------------
+*
+*   The file is the magic message, the network magic number and the object,
+*   followed by the double SHA256 of all of that. It is written and read as a
+*   stream, hashing on the way, so the object is never copied into memory as
+*   a whole.
 */
 
 template<typename T>
@@ -39,90 +43,86 @@ private:
 
     bool Write(const T& objToSave)
     {
-        // LOCK(objToSave.cs);
-
         int64_t nStart = GetTimeMillis();
 
-        // serialize, checksum data up to that point, then append checksum
-        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-        ssObj << strMagicMessage; // specific magic message for this type of object
-        ssObj << Params().MessageStart(); // network specific magic number
-        ssObj << objToSave;
-        uint256 hash = Hash(ssObj.begin(), ssObj.end());
-        ssObj << hash;
-
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
+        // write to a temporary file first, a crash halfway through leaves the old one intact
+        fs::path pathTmp = GetDataDir() / (strFilename + ".new");
+        FILE *file = fsbridge::fopen(pathTmp, "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
 
-        // Write and commit header, data
+        // serialize, checksum data up to that point, then append checksum
         try {
-            fileout << ssObj;
+            CHashedSourceWriter<CAutoFile> writer(&fileout);
+            writer << strMagicMessage; // specific magic message for this type of object
+            writer << Params().MessageStart(); // network specific magic number
+            writer << objToSave;
+            fileout << writer.GetHash();
         }
         catch (std::exception &e) {
             return error("%s: Serialize or I/O error - %s", __func__, e.what());
         }
+        if (!FileCommit(fileout.Get()))
+            return error("%s: Failed to flush file %s", __func__, pathTmp.string());
         fileout.fclose();
 
+        if (!RenameOver(pathTmp, pathDB))
+            return error("%s: Rename-into-place failed", __func__);
+
         LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToSave.ToString());
 
         return true;
     }
 
-    ReadResult Read(T& objToLoad, bool fDryRun = false)
+    /// Hash the rest of the data and compare it with the checksum at the end of the file
+    ReadResult ReadHash(CAutoFile& filein, CHashVerifier<CAutoFile>& verifier, int64_t nDataSize)
     {
-        //LOCK(objToLoad.cs);
-
-        int64_t nStart = GetTimeMillis();
-        // open input file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "rb");
-        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-        if (filein.IsNull())
-        {
-            error("%s: Failed to open file %s", __func__, pathDB.string());
-            return FileError;
-        }
-
-        // use file size to size memory buffer
-        int fileSize = boost::filesystem::file_size(pathDB);
-        int dataSize = fileSize - sizeof(uint256);
-        // Don't try to resize to a negative number if file is small
-        if (dataSize < 0)
-            dataSize = 0;
-        std::vector<unsigned char> vchData;
-        vchData.resize(dataSize);
         uint256 hashIn;
-
-        // read data and checksum from file
         try {
-            filein.read((char *)&vchData[0], dataSize);
+            long nPos = ftell(filein.Get());
+            if (nPos < 0 || nPos > nDataSize)
+                throw std::ios_base::failure("Data runs into the checksum");
+            verifier.ignore(nDataSize - nPos);
             filein >> hashIn;
         }
         catch (std::exception &e) {
             error("%s: Deserialize or I/O error - %s", __func__, e.what());
             return HashReadError;
         }
-        filein.fclose();
-
-        CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
 
-        // verify stored checksum matches input data
-        uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-        if (hashIn != hashTmp)
+        if (hashIn != verifier.GetHash())
         {
             error("%s: Checksum mismatch, data corrupted", __func__);
             return IncorrectHash;
         }
 
+        return Ok;
+    }
+
+    /// Check the file and, unless pobjToLoad is null, deserialize the object from it
+    ReadResult Read(T* pobjToLoad)
+    {
+        int64_t nStart = GetTimeMillis();
+        // open input file, and associate with CAutoFile
+        FILE *file = fsbridge::fopen(pathDB, "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+        {
+            error("%s: Failed to open file %s", __func__, pathDB.string());
+            return FileError;
+        }
+
+        // everything but the checksum at the end is hashed while it is read
+        int64_t nDataSize = std::max<int64_t>((int64_t)fs::file_size(pathDB) - (int64_t)sizeof(uint256), 0);
+        CHashVerifier<CAutoFile> verifier(&filein);
 
         unsigned char pchMsgTmp[4];
         std::string strMagicMessageTmp;
         try {
             // de-serialize file header (file specific magic message) and ..
-            ssObj >> strMagicMessageTmp;
+            verifier >> strMagicMessageTmp;
 
             // ... verify the message matches predefined one
             if (strMagicMessage != strMagicMessageTmp)
@@ -133,7 +133,7 @@ private:
 
 
             // de-serialize file header (network specific magic number) and ..
-            ssObj >> pchMsgTmp;
+            verifier >> pchMsgTmp;
 
             // ... verify the network matches ours
             if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
@@ -143,20 +143,36 @@ private:
             }
 
             // de-serialize data into T object
-            ssObj >> objToLoad;
+            if (pobjToLoad)
+                verifier >> *pobjToLoad;
         }
         catch (std::exception &e) {
-            objToLoad.Clear();
+            if (pobjToLoad)
+                pobjToLoad->Clear();
             error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            return IncorrectFormat;
+
+            // only data that is intact can be in an invalid format rather than corrupted, hash it all over again
+            rewind(filein.Get());
+            CHashVerifier<CAutoFile> verifierAll(&filein);
+            ReadResult readResult = ReadHash(filein, verifierAll, nDataSize);
+            return readResult == Ok ? IncorrectFormat : readResult;
         }
 
-        LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
-        LogPrintf("     %s\n", objToLoad.ToString());
-        if(!fDryRun) {
+        ReadResult readResult = ReadHash(filein, verifier, nDataSize);
+        if (readResult != Ok)
+        {
+            if (pobjToLoad)
+                pobjToLoad->Clear();
+            return readResult;
+        }
+        filein.fclose();
+
+        if (pobjToLoad) {
+            LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+            LogPrintf("     %s\n", pobjToLoad->ToString());
             LogPrintf("%s: Cleaning....\n", __func__);
-            objToLoad.CheckAndRemove();
-            LogPrintf("     %s\n", objToLoad.ToString());
+            pobjToLoad->CheckAndRemove();
+            LogPrintf("     %s\n", pobjToLoad->ToString());
         }
 
         return Ok;
@@ -174,7 +190,7 @@ public:
     bool Load(T& objToLoad)
     {
         LogPrintf("Reading info from %s...\n", strFilename);
-        ReadResult readResult = Read(objToLoad);
+        ReadResult readResult = Read(&objToLoad);
         if (readResult == FileError)
             LogPrintf("Missing file %s, will try to recreate\n", strFilename);
         else if (readResult != Ok)
@@ -193,13 +209,13 @@ public:
         return true;
     }
 
-    bool Dump(T& objToSave)
+    bool Dump(const T& objToSave)
     {
         int64_t nStart = GetTimeMillis();
 
+        // the header and the checksum tell whether the file is ours to replace, the data itself doesn't matter
         LogPrintf("Verifying %s format...\n", strFilename);
-        T tmpObjToLoad;
-        ReadResult readResult = Read(tmpObjToLoad, true);
+        ReadResult readResult = Read(nullptr);
 
         // there was an error and it was not an error on file opening => do not proceed
         if (readResult == FileError)
@@ -217,7 +233,8 @@ public:
         }
 
         LogPrintf("Writing info to %s...\n", strFilename);
-        Write(objToSave);
+        if (!Write(objToSave))
+            return false;
         LogPrintf("%s dump finished  %dms\n", strFilename, GetTimeMillis() - nStart);
 
         return true;
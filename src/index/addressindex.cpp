@@ -0,0 +1,273 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <coins.h>
+#include <crypto/sha256.h>
+#include <index/addressindex.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+
+constexpr char DB_ADDRESS_HISTORY = 'a';
+constexpr char DB_ADDRESS_UNSPENT = 'u';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+static uint256 GetScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+/**
+ * History entry key. Heights and positions are stored big-endian so that the
+ * entries of a script are iterated in chain order.
+ */
+struct DBHistoryKey
+{
+    uint256 script_hash;
+    int height;
+    uint32_t tx_pos;
+    uint32_t index;
+    bool spending;
+
+    DBHistoryKey() : height(0), tx_pos(0), index(0), spending(false) {}
+    DBHistoryKey(const uint256& script_hash_in, int height_in, uint32_t tx_pos_in, uint32_t index_in, bool spending_in) :
+        script_hash(script_hash_in), height(height_in), tx_pos(tx_pos_in), index(index_in), spending(spending_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS_HISTORY);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, tx_pos);
+        ser_writedata32be(s, index);
+        ser_writedata8(s, spending);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_ADDRESS_HISTORY) {
+            throw std::ios_base::failure("Invalid format for address history DB key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        tx_pos = ser_readdata32be(s);
+        index = ser_readdata32be(s);
+        spending = ser_readdata8(s) != 0;
+    }
+};
+
+/** Unspent output key, ordered by the height the output was created at. */
+struct DBUnspentKey
+{
+    uint256 script_hash;
+    int height;
+    COutPoint outpoint;
+
+    DBUnspentKey() : height(0) {}
+    DBUnspentKey(const uint256& script_hash_in, int height_in, const COutPoint& outpoint_in) :
+        script_hash(script_hash_in), height(height_in), outpoint(outpoint_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS_UNSPENT);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        s << outpoint.hash;
+        ser_writedata32be(s, outpoint.n);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_ADDRESS_UNSPENT) {
+            throw std::ios_base::failure("Invalid format for address unspent DB key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        s >> outpoint.hash;
+        outpoint.n = ser_readdata32be(s);
+    }
+};
+
+/**
+ * Access to the address index database (indexes/addressindex/)
+ *
+ * History entries map to the txid and value, unspent entries to the value.
+ * Like the txindex, the database stores a block locator of the chain it is
+ * synced to.
+ */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Call fn on the entries of key's type and script hash, starting at key.
+    /// Stops when fn returns false.
+    template<typename K, typename V, typename F>
+    bool ForEach(const K& key, F fn) const
+    {
+        std::unique_ptr<CDBIterator> it(const_cast<DB*>(this)->NewIterator());
+        K key_it;
+        V value;
+        for (it->Seek(key); it->Valid(); it->Next()) {
+            if (!it->GetKey(key_it) || key_it.script_hash != key.script_hash) break;
+            if (!it->GetValue(value)) {
+                return error("%s: failed to read value", __func__);
+            }
+            if (!fn(key_it, value)) break;
+        }
+        return true;
+    }
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Outputs of the genesis block are not spendable
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: undo data of block %s does not match", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CDBBatch batch(*m_db);
+    for (uint32_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        if (i > 0) {
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin = tx_undo.vprevout[j];
+                const uint256 script_hash = GetScriptHash(coin.out.scriptPubKey);
+                batch.Erase(DBUnspentKey(script_hash, coin.nHeight, tx.vin[j].prevout));
+                batch.Write(DBHistoryKey(script_hash, pindex->nHeight, i, j, true), std::make_pair(txid, -coin.out.nValue));
+            }
+        }
+
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            const uint256 script_hash = GetScriptHash(out.scriptPubKey);
+            batch.Write(DBUnspentKey(script_hash, pindex->nHeight, COutPoint(txid, j)), out.nValue);
+            batch.Write(DBHistoryKey(script_hash, pindex->nHeight, i, j, false), std::make_pair(txid, out.nValue));
+        }
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // Undo all blocks in one batch so that a failure leaves the index at current_tip
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        CBlockUndo block_undo;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!UndoReadFromDisk(block_undo, pindex) || block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+            return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+
+        for (uint32_t i = block.vtx.size(); i-- > 0;) {
+            const CTransaction& tx = *block.vtx[i];
+            const uint256& txid = tx.GetHash();
+
+            for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+                const CTxOut& out = tx.vout[j];
+                if (out.scriptPubKey.IsUnspendable()) continue;
+                const uint256 script_hash = GetScriptHash(out.scriptPubKey);
+                batch.Erase(DBUnspentKey(script_hash, pindex->nHeight, COutPoint(txid, j)));
+                batch.Erase(DBHistoryKey(script_hash, pindex->nHeight, i, j, false));
+            }
+
+            if (i > 0) {
+                const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+                for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                    const Coin& coin = tx_undo.vprevout[j];
+                    const uint256 script_hash = GetScriptHash(coin.out.scriptPubKey);
+                    batch.Erase(DBHistoryKey(script_hash, pindex->nHeight, i, j, true));
+                    batch.Write(DBUnspentKey(script_hash, coin.nHeight, tx.vin[j].prevout), coin.out.nValue);
+                }
+            }
+        }
+    }
+    if (!m_db->WriteBatch(batch)) {
+        return error("%s: failed to write rewound entries", __func__);
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::FindHistory(const CScript& script, size_t skip, size_t count, std::vector<CAddressHistoryEntry>& entries) const
+{
+    entries.clear();
+    if (count == 0) return true;
+    return m_db->ForEach<DBHistoryKey, std::pair<uint256, CAmount>>(DBHistoryKey(GetScriptHash(script), 0, 0, 0, false),
+        [&](const DBHistoryKey& key, const std::pair<uint256, CAmount>& value) {
+            if (skip > 0) {
+                --skip;
+                return true;
+            }
+            entries.push_back(CAddressHistoryEntry{key.height, value.first, key.index, key.spending, value.second});
+            return entries.size() < count;
+        });
+}
+
+bool AddressIndex::FindUnspent(const CScript& script, size_t skip, size_t count, std::vector<CAddressUnspentEntry>& entries) const
+{
+    entries.clear();
+    if (count == 0) return true;
+    return m_db->ForEach<DBUnspentKey, CAmount>(DBUnspentKey(GetScriptHash(script), 0, COutPoint(uint256(), 0)),
+        [&](const DBUnspentKey& key, CAmount value) {
+            if (skip > 0) {
+                --skip;
+                return true;
+            }
+            entries.push_back(CAddressUnspentEntry{key.outpoint, key.height, value});
+            return entries.size() < count;
+        });
+}
+
+bool AddressIndex::GetBalance(const CScript& script, CAmount& balance, CAmount& received) const
+{
+    const uint256 script_hash = GetScriptHash(script);
+    balance = 0;
+    received = 0;
+    return m_db->ForEach<DBUnspentKey, CAmount>(DBUnspentKey(script_hash, 0, COutPoint(uint256(), 0)),
+            [&](const DBUnspentKey& key, CAmount value) {
+                balance += value;
+                return true;
+            }) &&
+        m_db->ForEach<DBHistoryKey, std::pair<uint256, CAmount>>(DBHistoryKey(script_hash, 0, 0, 0, false),
+            [&](const DBHistoryKey& key, const std::pair<uint256, CAmount>& value) {
+                if (!key.spending) received += value.second;
+                return true;
+            });
+}
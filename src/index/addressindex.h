@@ -0,0 +1,85 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <script/script.h>
+
+/** One output paid to or spent from a script, in chain order. */
+struct CAddressHistoryEntry
+{
+    int nHeight;
+    uint256 txid;
+    //! vout of the output received, or vin of the input spending it
+    uint32_t nIndex;
+    bool fSpending;
+    //! negative for spends
+    CAmount nValue;
+};
+
+/** One output paid to a script that is still unspent. */
+struct CAddressUnspentEntry
+{
+    COutPoint outpoint;
+    int nHeight;
+    CAmount nValue;
+};
+
+/**
+ * AddressIndex is used to look up the outputs paid to and spent from a script.
+ * The index is written to a LevelDB database and records, by hash of the
+ * script, every output received and spent in block order, and the outputs
+ * that are still unspent. Spends are resolved from the block undo data, so
+ * the index can be built in the background like the txindex and rewound
+ * when a reorg leaves blocks it already indexed.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    /// Undo the entries of the blocks being disconnected.
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Page through the outputs received and spent by a script, oldest first.
+    ///
+    /// @param[in]   script  The script paid to.
+    /// @param[in]   skip  Number of entries to skip.
+    /// @param[in]   count  Most entries to return.
+    /// @param[out]  entries  The entries found.
+    /// @return  false if the database could not be read
+    bool FindHistory(const CScript& script, size_t skip, size_t count, std::vector<CAddressHistoryEntry>& entries) const;
+
+    /// Page through the unspent outputs paid to a script, oldest first.
+    bool FindUnspent(const CScript& script, size_t skip, size_t count, std::vector<CAddressUnspentEntry>& entries) const;
+
+    /// Total of the unspent outputs paid to a script, and of everything it ever received.
+    bool GetBalance(const CScript& script, CAmount& balance, CAmount& received) const;
+};
+
+/// The global address index, used by the address RPCs. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -0,0 +1,75 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SPENTINDEX_H
+#define BITCOIN_INDEX_SPENTINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <serialize.h>
+
+/** The input that spends an output in the active chain. */
+struct CSpentIndexEntry
+{
+    uint256 txid;
+    uint32_t nInputIndex;
+    int nHeight;
+
+    CSpentIndexEntry() : nInputIndex(0), nHeight(0) {}
+    CSpentIndexEntry(const uint256& txidIn, uint32_t nInputIndexIn, int nHeightIn) :
+        txid(txidIn), nInputIndex(nInputIndexIn), nHeight(nHeightIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(VARINT(nInputIndex));
+        READWRITE(VARINT(nHeight, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+/**
+ * SpentIndex is used to look up the transaction spending an output. The index
+ * is written to a LevelDB database and records, by outpoint, the spending
+ * txid, input and height, so the lookup doesn't depend on where the output
+ * was created.
+ */
+class SpentIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    /// Erase the spends of the blocks being disconnected.
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "spentindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit SpentIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~SpentIndex() override;
+
+    /// Look up the input spending an output.
+    ///
+    /// @param[in]   outpoint  The output spent.
+    /// @param[out]  entry  The spending transaction, input and height.
+    /// @return  true if the output is spent in the indexed chain, false otherwise
+    bool FindSpent(const COutPoint& outpoint, CSpentIndexEntry& entry) const;
+};
+
+/// The global spent index, used by getspentinfo and REST. May be null.
+extern std::unique_ptr<SpentIndex> g_spentindex;
+
+#endif // BITCOIN_INDEX_SPENTINDEX_H
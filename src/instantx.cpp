@@ -11,6 +11,7 @@
 #include <masternode-sync.h>
 #include <masternodeman.h>
 #include <messagesigner.h>
+#include <messageverifier.h>
 #include <net.h>
 #include <netmessagemaker.h>
 #include <protocol.h>
@@ -62,23 +63,32 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
             return;
         }
 
-        CTxLockVote vote;
-        vRecv >> vote;
+        auto pvote = std::make_shared<CTxLockVote>();
+        vRecv >> *pvote;
+        const CTxLockVote& vote = *pvote;
 
         uint256 nVoteHash = vote.GetHash();
 
-        pfrom->setAskFor.erase(nVoteHash);
+        pfrom->RemoveAskFor(nVoteHash);
 
         // Ignore any InstantSend messages until masternode list is synced
         if(!masternodeSync.IsMasternodeListSynced()) return;
 
         {
             LOCK(cs_instantsend);
-            auto ret = mapTxLockVotes.emplace(nVoteHash, vote);
-            if (!ret.second) return;
+            if (!AddTxLockVote(vote)) return;
         }
 
-        ProcessNewTxLockVote(pfrom, vote, connman);
+        // recover the signer off this thread, unless an unknown masternode makes the vote invalid anyway
+        std::vector<CMessageSigCheck> vChecks;
+        masternode_info_t infoMn;
+        if (mnodeman.GetMasternodeInfo(vote.GetMasternodeOutpoint(), infoMn)) {
+            vChecks.emplace_back(vote.GetSignatureMessage(), vote.GetSignature(), pvote->recoveredSigner, infoMn.pubKeyMasternode.GetID());
+        }
+
+        messageVerifier.Push(pfrom, vChecks, [this, pvote, &connman](CNode* pfrom) {
+            ProcessNewTxLockVote(pfrom, *pvote, connman);
+        });
 
         return;
     }
@@ -97,7 +107,7 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
 
     // Check to see if we conflict with existing completed lock
     for (const auto& txin : txLockRequest.tx->vin) {
-        std::map<COutPoint, uint256>::iterator it = mapLockedOutpoints.find(txin.prevout);
+        auto it = mapLockedOutpoints.find(txin.prevout);
         if(it != mapLockedOutpoints.end() && it->second != txLockRequest.GetHash()) {
             // Conflicting with complete lock, proceed to see if we should cancel them both
             LogPrintf("CInstantSend::ProcessTxLockRequest -- WARNING: Found conflicting completed Transaction Lock, txid=%s, completed lock txid=%s\n",
@@ -108,7 +118,7 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
     // Check to see if there are votes for conflicting request,
     // if so - do not fail, just warn user
     for (const auto& txin : txLockRequest.tx->vin) {
-        std::map<COutPoint, std::set<uint256> >::iterator it = mapVotedOutpoints.find(txin.prevout);
+        auto it = mapVotedOutpoints.find(txin.prevout);
         if(it != mapVotedOutpoints.end()) {
             for (const auto& hash : it->second) {
                 if(hash != txLockRequest.GetHash()) {
@@ -130,8 +140,8 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
     // Masternodes will sometimes propagate votes before the transaction is known to the client.
     // If this just happened - process orphan votes, lock inputs, resolve conflicting locks,
     // update transaction status forcing external script/zmq notifications.
-    ProcessOrphanTxLockVotes();
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    ProcessOrphanTxLockVotes(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     TryToFinalizeLockCandidate(itLockCandidate->second);
 
     return true;
@@ -145,7 +155,7 @@ bool CInstantSend::CreateTxLockCandidate(const CTxLockRequest& txLockRequest)
 
     uint256 txHash = txLockRequest.GetHash();
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate == mapTxLockCandidates.end()) {
         LogPrintf("CInstantSend::CreateTxLockCandidate -- new, txid=%s\n", txHash.ToString());
 
@@ -184,6 +194,143 @@ void CInstantSend::CreateEmptyTxLockCandidate(const uint256& txHash)
     mapTxLockCandidates.insert(std::make_pair(txHash, CTxLockCandidate(txLockRequest)));
 }
 
+void CInstantSend::EraseTxLockCandidate(const uint256& txHash)
+{
+    AssertLockHeld(cs_instantsend);
+
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
+    if (itLockCandidate == mapTxLockCandidates.end()) return;
+
+    for (const auto& outpointLock : itLockCandidate->second.mapOutPointLocks) {
+        mapLockedOutpoints.erase(outpointLock.first);
+        mapVotedOutpoints.erase(outpointLock.first);
+    }
+    setTxLockCandidatesByHeight.erase(std::make_pair(itLockCandidate->second.GetConfirmedHeight(), txHash));
+    mapLockRequestAccepted.erase(txHash);
+    mapLockRequestRejected.erase(txHash);
+    mapTxLockCandidates.erase(itLockCandidate);
+
+    // its votes aren't for a locked transaction anymore, they may fail now
+    auto itVotes = mapTxLockVotesByTx.find(txHash);
+    if (itVotes != mapTxLockVotesByTx.end()) {
+        for (const auto& nVoteHash : itVotes->second) {
+            setTxLockVotesByTime.emplace(mapTxLockVotes.at(nVoteHash).GetTimeCreated(), nVoteHash);
+        }
+    }
+}
+
+void CInstantSend::SetTxLockCandidateConfirmedHeight(const uint256& txHash, CTxLockCandidate& txLockCandidate, int nConfirmedHeight)
+{
+    AssertLockHeld(cs_instantsend);
+
+    setTxLockCandidatesByHeight.erase(std::make_pair(txLockCandidate.GetConfirmedHeight(), txHash));
+    txLockCandidate.SetConfirmedHeight(nConfirmedHeight);
+    if (nConfirmedHeight != -1) {
+        setTxLockCandidatesByHeight.emplace(nConfirmedHeight, txHash);
+    }
+}
+
+bool CInstantSend::AddTxLockVote(const CTxLockVote& vote)
+{
+    AssertLockHeld(cs_instantsend);
+
+    uint256 nVoteHash = vote.GetHash();
+    if (!mapTxLockVotes.emplace(nVoteHash, vote).second) return false;
+    mapTxLockVotesByTx[vote.GetTxHash()].insert(nVoteHash);
+    setTxLockVotesByTime.emplace(vote.GetTimeCreated(), nVoteHash);
+    if (vote.GetConfirmedHeight() != -1) {
+        setTxLockVotesByHeight.emplace(vote.GetConfirmedHeight(), nVoteHash);
+    }
+    return true;
+}
+
+bool CInstantSend::AddTxLockVoteOrphan(const CTxLockVote& vote, NodeId nodeId)
+{
+    AssertLockHeld(cs_instantsend);
+
+    uint256 nVoteHash = vote.GetHash();
+    if (mapTxLockVotesOrphan.count(nVoteHash)) return false;
+
+    int& nPeerOrphans = mapTxLockVotesOrphanPerPeer[nodeId];
+    if (nPeerOrphans >= MAX_ORPHAN_TXLOCK_VOTES_PER_PEER) {
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- peer=%d has too many orphan votes, ignoring vote %s\n", __func__, nodeId, nVoteHash.ToString());
+        // don't keep it around as a known vote either
+        EraseTxLockVote(nVoteHash);
+        return false;
+    }
+    ++nPeerOrphans;
+
+    mapTxLockVotesOrphan.emplace(nVoteHash, std::make_pair(vote, nodeId));
+    setTxLockVotesOrphanByTime.emplace(vote.GetTimeCreated(), nVoteHash);
+    nTxLockVotesOrphanUsage += vote.DynamicMemoryUsage();
+
+    // make room by dropping the oldest ones
+    while (DynamicOrphanVotesUsage() > MAX_ORPHAN_TXLOCK_VOTES_USAGE) {
+        uint256 nVoteHashOldest = setTxLockVotesOrphanByTime.begin()->second;
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- orphan votes are full, dropping vote %s\n", __func__, nVoteHashOldest.ToString());
+        EraseTxLockVote(nVoteHashOldest);
+        EraseTxLockVoteOrphan(nVoteHashOldest);
+    }
+    return mapTxLockVotesOrphan.count(nVoteHash);
+}
+
+void CInstantSend::EraseTxLockVote(const uint256& nVoteHash)
+{
+    AssertLockHeld(cs_instantsend);
+
+    auto itVote = mapTxLockVotes.find(nVoteHash);
+    if (itVote == mapTxLockVotes.end()) return;
+
+    const CTxLockVote& vote = itVote->second;
+    setTxLockVotesByTime.erase(std::make_pair(vote.GetTimeCreated(), nVoteHash));
+    setTxLockVotesByHeight.erase(std::make_pair(vote.GetConfirmedHeight(), nVoteHash));
+    auto itVotes = mapTxLockVotesByTx.find(vote.GetTxHash());
+    if (itVotes != mapTxLockVotesByTx.end()) {
+        itVotes->second.erase(nVoteHash);
+        if (itVotes->second.empty()) {
+            mapTxLockVotesByTx.erase(itVotes);
+        }
+    }
+    mapTxLockVotes.erase(itVote);
+}
+
+void CInstantSend::EraseTxLockVoteOrphan(const uint256& nVoteHash)
+{
+    AssertLockHeld(cs_instantsend);
+
+    auto itOrphanVote = mapTxLockVotesOrphan.find(nVoteHash);
+    if (itOrphanVote == mapTxLockVotesOrphan.end()) return;
+
+    const CTxLockVote& vote = itOrphanVote->second.first;
+    NodeId nodeId = itOrphanVote->second.second;
+    setTxLockVotesOrphanByTime.erase(std::make_pair(vote.GetTimeCreated(), nVoteHash));
+    nTxLockVotesOrphanUsage -= vote.DynamicMemoryUsage();
+    auto itPeer = mapTxLockVotesOrphanPerPeer.find(nodeId);
+    if (itPeer != mapTxLockVotesOrphanPerPeer.end() && --itPeer->second <= 0) {
+        mapTxLockVotesOrphanPerPeer.erase(itPeer);
+    }
+    mapTxLockVotesOrphan.erase(itOrphanVote);
+}
+
+void CInstantSend::SetTxLockVotesConfirmedHeight(const uint256& txHash, int nConfirmedHeight)
+{
+    AssertLockHeld(cs_instantsend);
+
+    auto itVotes = mapTxLockVotesByTx.find(txHash);
+    if (itVotes == mapTxLockVotesByTx.end()) return;
+
+    for (const auto& nVoteHash : itVotes->second) {
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::SetTxLockVotesConfirmedHeight -- txid=%s nHeightNew=%d vote %s updated\n",
+                txHash.ToString(), nConfirmedHeight, nVoteHash.ToString());
+        CTxLockVote& vote = mapTxLockVotes.at(nVoteHash);
+        setTxLockVotesByHeight.erase(std::make_pair(vote.GetConfirmedHeight(), nVoteHash));
+        vote.SetConfirmedHeight(nConfirmedHeight);
+        if (nConfirmedHeight != -1) {
+            setTxLockVotesByHeight.emplace(nConfirmedHeight, nVoteHash);
+        }
+    }
+}
+
 void CInstantSend::Vote(const uint256& txHash, CConnman& connman)
 {
     AssertLockHeld(cs_main);
@@ -247,14 +394,14 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::Vote -- In the top %d (%d)\n", nSignaturesTotal, nRank);
 
-        std::map<COutPoint, std::set<uint256> >::iterator itVoted = mapVotedOutpoints.find(itOutpointLock->first);
+        auto itVoted = mapVotedOutpoints.find(itOutpointLock->first);
 
         // Check to see if we already voted for this outpoint,
         // refuse to vote twice or to include the same outpoint in another tx
         bool fAlreadyVoted = false;
         if(itVoted != mapVotedOutpoints.end()) {
             for (const auto& hash : itVoted->second) {
-                std::map<uint256, CTxLockCandidate>::iterator it2 = mapTxLockCandidates.find(hash);
+                auto it2 = mapTxLockCandidates.find(hash);
                 if(it2->second.HasMasternodeVoted(itOutpointLock->first, activeMasternode.outpoint)) {
                     // we already voted for this outpoint to be included either in the same tx or in a competing one,
                     // skip it anyway
@@ -284,7 +431,7 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
         // vote constructed sucessfully, let's store and relay it
         uint256 nVoteHash = vote.GetHash();
-        mapTxLockVotes.insert(std::make_pair(nVoteHash, vote));
+        AddTxLockVote(vote);
         if(itOutpointLock->second.AddVote(vote)) {
             LogPrintf("CInstantSend::Vote -- Vote created successfully, relaying: txHash=%s, outpoint=%s, vote=%s\n",
                     txHash.ToString(), itOutpointLock->first.ToStringShort(), nVoteHash.ToString());
@@ -333,14 +480,14 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
     // Masternodes will sometimes propagate votes before the transaction is known to the client,
     // will actually process only after the lock request itself has arrived
 
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest) {
         // no or empty tx lock candidate
         if(it == mapTxLockCandidates.end()) {
             // start timeout countdown after the very first vote
             CreateEmptyTxLockCandidate(txHash);
         }
-        bool fInserted = mapTxLockVotesOrphan.emplace(nVoteHash, vote).second;
+        bool fInserted = AddTxLockVoteOrphan(vote, pfrom->GetId());
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- Orphan vote: txid=%s  masternode=%s %s\n",
                 __func__, txHash.ToString(), vote.GetMasternodeOutpoint().ToStringShort(), fInserted ? "new" : "seen");
 
@@ -406,7 +553,7 @@ bool CInstantSend::ProcessOrphanTxLockVote(const CTxLockVote& vote)
     uint256 txHash = vote.GetTxHash();
 
     // We shouldn't process orphan votes without a valid tx lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest)
         return false; // this shouldn never happen
 
@@ -440,14 +587,14 @@ void CInstantSend::UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidat
 
     uint256 txHash = vote.GetTxHash();
 
-    std::map<COutPoint, std::set<uint256> >::iterator it1 = mapVotedOutpoints.find(vote.GetOutpoint());
+    auto it1 = mapVotedOutpoints.find(vote.GetOutpoint());
     if(it1 != mapVotedOutpoints.end()) {
         for (const auto& hash : it1->second) {
             if(hash != txHash) {
                 // same outpoint was already voted to be locked by another tx lock request,
                 // let's see if it was the same masternode who voted on this outpoint
                 // for another tx lock request
-                std::map<uint256, CTxLockCandidate>::iterator it2 = mapTxLockCandidates.find(hash);
+                auto it2 = mapTxLockCandidates.find(hash);
                 if(it2 !=mapTxLockCandidates.end() && it2->second.HasMasternodeVoted(vote.GetOutpoint(), vote.GetMasternodeOutpoint())) {
                     // yes, it was the same masternode
                     LogPrintf("CInstantSend::%s -- masternode sent conflicting votes! %s\n", __func__, vote.GetMasternodeOutpoint().ToStringShort());
@@ -471,17 +618,19 @@ void CInstantSend::UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidat
     }
 }
 
-void CInstantSend::ProcessOrphanTxLockVotes()
+void CInstantSend::ProcessOrphanTxLockVotes(const uint256& txHash)
 {
     AssertLockHeld(cs_main);
     AssertLockHeld(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.begin();
-    while(it != mapTxLockVotesOrphan.end()) {
-        if(ProcessOrphanTxLockVote(it->second)) {
-            mapTxLockVotesOrphan.erase(it++);
-        } else {
-            ++it;
+    // only the votes for txHash could have been waiting for its lock request
+    auto itVotes = mapTxLockVotesByTx.find(txHash);
+    if(itVotes == mapTxLockVotesByTx.end()) return;
+
+    for (const auto& nVoteHash : itVotes->second) {
+        auto it = mapTxLockVotesOrphan.find(nVoteHash);
+        if(it != mapTxLockVotesOrphan.end() && ProcessOrphanTxLockVote(it->second.first)) {
+            EraseTxLockVoteOrphan(nVoteHash);
         }
     }
 }
@@ -555,7 +704,7 @@ void CInstantSend::LockTransactionInputs(const CTxLockCandidate& txLockCandidate
 bool CInstantSend::GetLockedOutPointTxHash(const COutPoint& outpoint, uint256& hashRet)
 {
     LOCK(cs_instantsend);
-    std::map<COutPoint, uint256>::iterator it = mapLockedOutpoints.find(outpoint);
+    auto it = mapLockedOutpoints.find(outpoint);
     if(it == mapLockedOutpoints.end()) return false;
     hashRet = it->second;
     return true;
@@ -578,8 +727,8 @@ bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
         if(GetLockedOutPointTxHash(txin.prevout, hashConflicting) && txHash != hashConflicting) {
             // completed lock which conflicts with another completed one?
             // this means that majority of MNs in the quorum for this specific tx input are malicious!
-            std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
-            std::map<uint256, CTxLockCandidate>::iterator itLockCandidateConflicting = mapTxLockCandidates.find(hashConflicting);
+            auto itLockCandidate = mapTxLockCandidates.find(txHash);
+            auto itLockCandidateConflicting = mapTxLockCandidates.find(hashConflicting);
             if(itLockCandidate == mapTxLockCandidates.end() || itLockCandidateConflicting == mapTxLockCandidates.end()) {
                 // safety check, should never really happen
                 LogPrintf("CInstantSend::ResolveConflicts -- ERROR: Found conflicting completed Transaction Lock, but one of txLockCandidate-s is missing, txid=%s, conflicting txid=%s\n",
@@ -590,8 +739,8 @@ bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
                     txHash.ToString(), hashConflicting.ToString());
             CTxLockRequest txLockRequest = itLockCandidate->second.txLockRequest;
             CTxLockRequest txLockRequestConflicting = itLockCandidateConflicting->second.txLockRequest;
-            itLockCandidate->second.SetConfirmedHeight(0); // expired
-            itLockCandidateConflicting->second.SetConfirmedHeight(0); // expired
+            SetTxLockCandidateConfirmedHeight(txHash, itLockCandidate->second, 0); // expired
+            SetTxLockCandidateConfirmedHeight(hashConflicting, itLockCandidateConflicting->second, 0); // expired
             CheckAndRemove(); // clean up
             // AlreadyHave should still return "true" for both of them
             mapLockRequestRejected.insert(std::make_pair(txHash, txLockRequest));
@@ -660,62 +809,48 @@ void CInstantSend::CheckAndRemove()
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.begin();
+    // Locks and votes expire nInstantSendKeepLock blocks after the block corresponding tx was included into.
+    int nExpiredHeight = nCachedBlockHeight - Params().GetConsensus().nInstantSendKeepLock;
 
     // remove expired candidates
-    while(itLockCandidate != mapTxLockCandidates.end()) {
-        CTxLockCandidate &txLockCandidate = itLockCandidate->second;
-        uint256 txHash = txLockCandidate.GetHash();
-        if(txLockCandidate.IsExpired(nCachedBlockHeight)) {
-            LogPrintf("CInstantSend::CheckAndRemove -- Removing expired Transaction Lock Candidate: txid=%s\n", txHash.ToString());
-            std::map<COutPoint, COutPointLock>::iterator itOutpointLock = txLockCandidate.mapOutPointLocks.begin();
-            while(itOutpointLock != txLockCandidate.mapOutPointLocks.end()) {
-                mapLockedOutpoints.erase(itOutpointLock->first);
-                mapVotedOutpoints.erase(itOutpointLock->first);
-                ++itOutpointLock;
-            }
-            mapLockRequestAccepted.erase(txHash);
-            mapLockRequestRejected.erase(txHash);
-            mapTxLockCandidates.erase(itLockCandidate++);
-        } else {
-            ++itLockCandidate;
-        }
+    while(!setTxLockCandidatesByHeight.empty() && setTxLockCandidatesByHeight.begin()->first < nExpiredHeight) {
+        uint256 txHash = setTxLockCandidatesByHeight.begin()->second;
+        setTxLockCandidatesByHeight.erase(setTxLockCandidatesByHeight.begin());
+        LogPrintf("CInstantSend::CheckAndRemove -- Removing expired Transaction Lock Candidate: txid=%s\n", txHash.ToString());
+        EraseTxLockCandidate(txHash);
     }
 
     // remove expired votes
-    std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsExpired(nCachedBlockHeight)) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
-                    itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
-        }
+    while(!setTxLockVotesByHeight.empty() && setTxLockVotesByHeight.begin()->first < nExpiredHeight) {
+        uint256 nVoteHash = setTxLockVotesByHeight.begin()->second;
+        setTxLockVotesByHeight.erase(setTxLockVotesByHeight.begin());
+        const CTxLockVote& vote = mapTxLockVotes.at(nVoteHash);
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
+                vote.GetTxHash().ToString(), vote.GetMasternodeOutpoint().ToStringShort());
+        EraseTxLockVote(nVoteHash);
     }
 
     // remove timed out orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.IsTimedOut()) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
-                    itOrphanVote->second.GetTxHash().ToString(), itOrphanVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itOrphanVote->first);
-            mapTxLockVotesOrphan.erase(itOrphanVote++);
-        } else {
-            ++itOrphanVote;
-        }
+    while(!setTxLockVotesOrphanByTime.empty() && GetTime() - setTxLockVotesOrphanByTime.begin()->first > INSTANTSEND_LOCK_TIMEOUT_SECONDS) {
+        uint256 nVoteHash = setTxLockVotesOrphanByTime.begin()->second;
+        setTxLockVotesOrphanByTime.erase(setTxLockVotesOrphanByTime.begin());
+        const CTxLockVote& vote = mapTxLockVotesOrphan.at(nVoteHash).first;
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
+                vote.GetTxHash().ToString(), vote.GetMasternodeOutpoint().ToStringShort());
+        EraseTxLockVote(nVoteHash);
+        EraseTxLockVoteOrphan(nVoteHash);
     }
 
-    // remove invalid votes and votes for failed lock attempts
-    itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsFailed()) {
+    // remove invalid votes and votes for failed lock attempts,
+    // votes for locked transactions are looked at again once their lock candidate is gone
+    while(!setTxLockVotesByTime.empty() && GetTime() - setTxLockVotesByTime.begin()->first > INSTANTSEND_FAILED_TIMEOUT_SECONDS) {
+        uint256 nVoteHash = setTxLockVotesByTime.begin()->second;
+        setTxLockVotesByTime.erase(setTxLockVotesByTime.begin());
+        const CTxLockVote& vote = mapTxLockVotes.at(nVoteHash);
+        if(!IsLockedInstantSendTransaction(vote.GetTxHash())) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing vote for failed lock attempt: txid=%s  masternode=%s\n",
-                    itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
+                    vote.GetTxHash().ToString(), vote.GetMasternodeOutpoint().ToStringShort());
+            EraseTxLockVote(nVoteHash);
         }
     }
 
@@ -763,7 +898,7 @@ bool CInstantSend::GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLoc
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest) return false;
     txLockRequestRet = it->second.txLockRequest;
 
@@ -774,7 +909,7 @@ bool CInstantSend::GetTxLockVote(const uint256& hash, CTxLockVote& txLockVoteRet
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotes.find(hash);
+    auto it = mapTxLockVotes.find(hash);
     if(it == mapTxLockVotes.end()) return false;
     txLockVoteRet = it->second;
 
@@ -789,7 +924,7 @@ bool CInstantSend::IsInstantSendReadyToLock(const uint256& txHash)
     LOCK(cs_instantsend);
     // There must be a successfully verified lock request
     // and all outputs must be locked (i.e. have enough signatures)
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     return it != mapTxLockCandidates.end() && it->second.IsAllOutPointsReady();
 }
 
@@ -801,7 +936,7 @@ bool CInstantSend::IsLockedInstantSendTransaction(const uint256& txHash)
     LOCK(cs_instantsend);
 
     // there must be a lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate == mapTxLockCandidates.end()) return false;
 
     // which should have outpoints
@@ -825,7 +960,7 @@ int CInstantSend::GetTransactionLockSignatures(const uint256& txHash)
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate != mapTxLockCandidates.end()) {
         return itLockCandidate->second.CountVotes();
     }
@@ -844,7 +979,7 @@ bool CInstantSend::IsTxLockCandidateTimedOut(const uint256& txHash)
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if (itLockCandidate != mapTxLockCandidates.end()) {
         return !itLockCandidate->second.IsAllOutPointsReady() &&
                 itLockCandidate->second.IsTimedOut();
@@ -857,7 +992,7 @@ void CInstantSend::Relay(const uint256& txHash, CConnman& connman)
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::const_iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if (itLockCandidate != mapTxLockCandidates.end()) {
         itLockCandidate->second.Relay(connman);
     }
@@ -885,48 +1020,34 @@ void CInstantSend::SyncTransaction(const CTransaction& tx, const CBlockIndex *pi
     LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d\n", txHash.ToString(), nHeightNew);
 
     // Check lock candidates
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate != mapTxLockCandidates.end()) {
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d lock candidate updated\n",
                 txHash.ToString(), nHeightNew);
-        itLockCandidate->second.SetConfirmedHeight(nHeightNew);
-        // Loop through outpoint locks
-        std::map<COutPoint, COutPointLock>::iterator itOutpointLock = itLockCandidate->second.mapOutPointLocks.begin();
-        while(itOutpointLock != itLockCandidate->second.mapOutPointLocks.end()) {
-            // Check corresponding lock votes
-            std::vector<CTxLockVote> vVotes = itOutpointLock->second.GetVotes();
-            std::vector<CTxLockVote>::iterator itVote = vVotes.begin();
-            std::map<uint256, CTxLockVote>::iterator it;
-            while(itVote != vVotes.end()) {
-                uint256 nVoteHash = itVote->GetHash();
-                LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
-                        txHash.ToString(), nHeightNew, nVoteHash.ToString());
-                it = mapTxLockVotes.find(nVoteHash);
-                if(it != mapTxLockVotes.end()) {
-                    it->second.SetConfirmedHeight(nHeightNew);
-                }
-                ++itVote;
-            }
-            ++itOutpointLock;
-        }
+        SetTxLockCandidateConfirmedHeight(txHash, itLockCandidate->second, nHeightNew);
     }
 
-    // check orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.GetTxHash() == txHash) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
-                    txHash.ToString(), nHeightNew, itOrphanVote->first.ToString());
-            mapTxLockVotes[itOrphanVote->first].SetConfirmedHeight(nHeightNew);
-        }
-        ++itOrphanVote;
-    }
+    // and corresponding lock votes, orphan ones included
+    SetTxLockVotesConfirmedHeight(txHash, nHeightNew);
+}
+
+size_t CInstantSend::GetOrphanVoteCount()
+{
+    LOCK(cs_instantsend);
+    return mapTxLockVotesOrphan.size();
+}
+
+size_t CInstantSend::DynamicOrphanVotesUsage()
+{
+    LOCK(cs_instantsend);
+    return memusage::DynamicUsage(mapTxLockVotesOrphan) + memusage::DynamicUsage(setTxLockVotesOrphanByTime) +
+            memusage::DynamicUsage(mapTxLockVotesOrphanPerPeer) + nTxLockVotesOrphanUsage;
 }
 
 std::string CInstantSend::ToString()
 {
     LOCK(cs_instantsend);
-    return strprintf("Lock Candidates: %llu, Votes %llu", mapTxLockCandidates.size(), mapTxLockVotes.size());
+    return strprintf("Lock Candidates: %llu, Votes %llu, Orphan votes %llu", mapTxLockCandidates.size(), mapTxLockVotes.size(), mapTxLockVotesOrphan.size());
 }
 
 //
@@ -1053,6 +1174,11 @@ uint256 CTxLockVote::GetSignatureHash() const
     return GetHash();
 }
 
+std::string CTxLockVote::GetSignatureMessage() const
+{
+    return txHash.ToString() + outpoint.ToStringShort();
+}
+
 bool CTxLockVote::CheckSignature() const
 {
     std::string strError;
@@ -1064,8 +1190,8 @@ bool CTxLockVote::CheckSignature() const
         return false;
     }
 
-    std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
-    if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
+    std::string strMessage = GetSignatureMessage();
+    if(!CMessageSigner::VerifyMessageCached(infoMn.pubKeyMasternode, vchMasternodeSignature, strMessage, strError, &recoveredSigner)) {
         LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -1077,7 +1203,7 @@ bool CTxLockVote::Sign()
 {
     std::string strError;
 
-    std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
+    std::string strMessage = GetSignatureMessage();
 
     if(!CMessageSigner::SignMessage(strMessage, vchMasternodeSignature, activeMasternode.keyMasternode)) {
         LogPrintf("CTxLockVote::Sign -- SignMessage() failed\n");
@@ -5,8 +5,15 @@
 #define INSTANTX_H
 
 #include <chain.h>
+#include <coins.h>
+#include <memusage.h>
+#include <messagesigner.h>
 #include <net.h>
 #include <primitives/transaction.h>
+#include <txmempool.h>
+
+#include <set>
+#include <unordered_map>
 
 class CTxLockVote;
 class COutPointLock;
@@ -43,6 +50,11 @@ static const int INSTANTSEND_LOCK_TIMEOUT_SECONDS   = 15;
 /// must be greater than INSTANTSEND_LOCK_TIMEOUT_SECONDS
 static const int INSTANTSEND_FAILED_TIMEOUT_SECONDS = 60;
 
+/// Most memory orphan votes may take, the oldest ones are dropped to stay below it
+static const size_t MAX_ORPHAN_TXLOCK_VOTES_USAGE   = 10 * 1000 * 1000;
+/// Most orphan votes we keep from one peer, further ones from it are ignored
+static const int MAX_ORPHAN_TXLOCK_VOTES_PER_PEER   = 2000;
+
 extern bool fEnableInstantSend;
 extern int nInstantSendDepth;
 extern int nCompleteTXLocks;
@@ -57,21 +69,41 @@ private:
     int nCachedBlockHeight;
 
     // maps for AlreadyHave
-    std::map<uint256, CTxLockRequest> mapLockRequestAccepted; ///< Tx hash - Tx
-    std::map<uint256, CTxLockRequest> mapLockRequestRejected; ///< Tx hash - Tx
-    std::map<uint256, CTxLockVote> mapTxLockVotes; ///< Vote hash - Vote
-    std::map<uint256, CTxLockVote> mapTxLockVotesOrphan; ///< Vote hash - Vote
+    std::unordered_map<uint256, CTxLockRequest, SaltedTxidHasher> mapLockRequestAccepted; ///< Tx hash - Tx
+    std::unordered_map<uint256, CTxLockRequest, SaltedTxidHasher> mapLockRequestRejected; ///< Tx hash - Tx
+    std::unordered_map<uint256, CTxLockVote, SaltedTxidHasher> mapTxLockVotes; ///< Vote hash - Vote
+    std::unordered_map<uint256, std::pair<CTxLockVote, NodeId>, SaltedTxidHasher> mapTxLockVotesOrphan; ///< Vote hash - (Vote, Peer it came from)
+
+    std::unordered_map<uint256, CTxLockCandidate, SaltedTxidHasher> mapTxLockCandidates; ///< Tx hash - Lock candidate
 
-    std::map<uint256, CTxLockCandidate> mapTxLockCandidates; ///< Tx hash - Lock candidate
+    std::unordered_map<COutPoint, std::set<uint256>, SaltedOutpointHasher> mapVotedOutpoints; ///< UTXO - Tx hash set
+    std::unordered_map<COutPoint, uint256, SaltedOutpointHasher> mapLockedOutpoints; ///< UTXO - Tx hash
 
-    std::map<COutPoint, std::set<uint256> > mapVotedOutpoints; ///< UTXO - Tx hash set
-    std::map<COutPoint, uint256> mapLockedOutpoints; ///< UTXO - Tx hash
+    // indexes into the maps above, so that CheckAndRemove only visits what is due
+    std::unordered_map<uint256, std::set<uint256>, SaltedTxidHasher> mapTxLockVotesByTx; ///< Tx hash - Vote hash set
+    std::set<std::pair<int, uint256> > setTxLockCandidatesByHeight; ///< (Confirmed height, Tx hash) of confirmed candidates
+    std::set<std::pair<int, uint256> > setTxLockVotesByHeight; ///< (Confirmed height, Vote hash) of confirmed votes
+    std::set<std::pair<int64_t, uint256> > setTxLockVotesByTime; ///< (Time created, Vote hash) of votes which may still fail
+    std::set<std::pair<int64_t, uint256> > setTxLockVotesOrphanByTime; ///< (Time created, Vote hash) of orphan votes
+
+    std::map<NodeId, int> mapTxLockVotesOrphanPerPeer; ///< Peer - Number of orphan votes it sent
+    size_t nTxLockVotesOrphanUsage = 0; ///< Dynamic memory of the orphan votes themselves, see DynamicOrphanVotesUsage
 
     /// Track masternodes who voted with no txlockrequest (for DOS protection)
     std::map<COutPoint, int64_t> mapMasternodeOrphanVotes; ///< MN outpoint - Time
 
     bool CreateTxLockCandidate(const CTxLockRequest& txLockRequest);
     void CreateEmptyTxLockCandidate(const uint256& txHash);
+    void EraseTxLockCandidate(const uint256& txHash);
+    void SetTxLockCandidateConfirmedHeight(const uint256& txHash, CTxLockCandidate& txLockCandidate, int nConfirmedHeight);
+
+    /// Keep the vote indexes in sync with mapTxLockVotes and mapTxLockVotesOrphan
+    bool AddTxLockVote(const CTxLockVote& vote);
+    bool AddTxLockVoteOrphan(const CTxLockVote& vote, NodeId nodeId);
+    void EraseTxLockVote(const uint256& nVoteHash);
+    void EraseTxLockVoteOrphan(const uint256& nVoteHash);
+    void SetTxLockVotesConfirmedHeight(const uint256& txHash, int nConfirmedHeight);
+
     void Vote(CTxLockCandidate& txLockCandidate, CConnman& connman);
 
     /// Process consensus vote message
@@ -79,7 +111,7 @@ private:
 
     void UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidate& txLockCandidate);
     bool ProcessOrphanTxLockVote(const CTxLockVote& vote);
-    void ProcessOrphanTxLockVotes();
+    void ProcessOrphanTxLockVotes(const uint256& txHash);
     int64_t GetAverageMasternodeOrphanVoteTime();
 
     void TryToFinalizeLockCandidate(const CTxLockCandidate& txLockCandidate);
@@ -126,6 +158,11 @@ public:
     void UpdatedBlockTip(const CBlockIndex *pindex);
     void SyncTransaction(const CTransaction& tx, const CBlockIndex *pindex, int posInBlock);
 
+    /// Number of orphan votes waiting for their lock request
+    size_t GetOrphanVoteCount();
+    /// Memory taken by the orphan votes, kept below MAX_ORPHAN_TXLOCK_VOTES_USAGE
+    size_t DynamicOrphanVotesUsage();
+
     std::string ToString();
 };
 
@@ -201,6 +238,9 @@ private:
     int64_t nTimeCreated;
 
 public:
+    // not serialized, filled in by CMessageVerifier
+    CRecoveredSigner recoveredSigner;
+
     CTxLockVote() :
         txHash(),
         outpoint(),
@@ -237,17 +277,23 @@ public:
     uint256 GetTxHash() const { return txHash; }
     COutPoint GetOutpoint() const { return outpoint; }
     COutPoint GetMasternodeOutpoint() const { return outpointMasternode; }
+    const std::vector<unsigned char>& GetSignature() const { return vchMasternodeSignature; }
 
     bool IsValid(CNode* pnode, CConnman& connman) const;
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
     bool IsFailed() const;
+    int GetConfirmedHeight() const { return nConfirmedHeight; }
+    int64_t GetTimeCreated() const { return nTimeCreated; }
 
+    std::string GetSignatureMessage() const;
     bool Sign();
     bool CheckSignature() const;
 
     void Relay(CConnman& connman) const;
+
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(vchMasternodeSignature); }
 };
 
 /**
@@ -312,6 +358,7 @@ public:
     int CountVotes() const;
 
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
+    int GetConfirmedHeight() const { return nConfirmedHeight; }
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
 
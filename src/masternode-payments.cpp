@@ -10,6 +10,7 @@
 #include <masternode-sync.h>
 #include <masternodeman.h>
 #include <messagesigner.h>
+#include <messageverifier.h>
 #include <netfulfilledman.h>
 #include <netmessagemaker.h>
 #include <script/standard.h>
@@ -20,7 +21,6 @@
 /** Object for who's going to get paid on which blocks */
 CMasternodePayments mnpayments;
 
-CCriticalSection cs_vecPayees;
 CCriticalSection cs_mapMasternodeBlocks;
 CCriticalSection cs_mapMasternodePaymentVotes;
 
@@ -41,6 +41,7 @@ void CMasternodePayments::Clear()
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
     mapMasternodeBlocks.clear();
     mapMasternodePaymentVotes.clear();
+    mapVoteHashesByHeight.clear();
 }
 
 bool CMasternodePayments::UpdateLastVote(const CMasternodePaymentVote& vote)
@@ -162,8 +163,9 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
 
     } else if (strCommand == NetMsgType::MASTERNODEPAYMENTVOTE) { // Masternode Payments Vote for the Winner
 
-        CMasternodePaymentVote vote;
-        vRecv >> vote;
+        auto pvote = std::make_shared<CMasternodePaymentVote>();
+        vRecv >> *pvote;
+        const CMasternodePaymentVote& vote = *pvote;
 
         if(pfrom->nVersion < GetMinMasternodePaymentsProto()) {
             LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
@@ -174,7 +176,7 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
 
         uint256 nHash = vote.GetHash();
 
-        pfrom->setAskFor.erase(nHash);
+        pfrom->RemoveAskFor(nHash);
 
         // TODO: clear setAskFor for MSG_MASTERNODE_PAYMENT_BLOCK too
 
@@ -192,12 +194,16 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
                             nHash.ToString(), vote.nBlockHeight, nCachedBlockHeight);
                 return;
             }
+            if(res.second) {
+                mapVoteHashesByHeight[vote.nBlockHeight].push_back(nHash);
+            }
 
             // Mark vote as non-verified when it's seen for the first time,
             // AddOrUpdatePaymentVote() below should take care of it if vote is actually ok
             res.first->second.MarkAsNotVerified();
         }
 
+        // don't recover signers of votes the checks below would drop anyway
         int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
         if(vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > nCachedBlockHeight+20) {
             LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, nCachedBlockHeight);
@@ -210,48 +216,67 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
             return;
         }
 
+        // IsValid found the masternode, it is expected to be the signer
+        CKeyID keyIDMasternode;
         masternode_info_t mnInfo;
-        if(!mnodeman.GetMasternodeInfo(vote.masternodeOutpoint, mnInfo)) {
-            // mn was not found, so we can't check vote, some info is probably missing
-            LogPrintf("MASTERNODEPAYMENTVOTE -- masternode is missing %s\n", vote.masternodeOutpoint.ToStringShort());
-            mnodeman.AskForMN(pfrom, vote.masternodeOutpoint, connman);
-            return;
+        if(mnodeman.GetMasternodeInfo(vote.masternodeOutpoint, mnInfo)) {
+            keyIDMasternode = mnInfo.pubKeyMasternode.GetID();
         }
 
-        int nDos = 0;
-        if(!vote.CheckSignature(mnInfo.pubKeyMasternode, nCachedBlockHeight, nDos)) {
-            if(nDos) {
-                LOCK(cs_main);
-                LogPrintf("MASTERNODEPAYMENTVOTE -- ERROR: invalid signature\n");
-                Misbehaving(pfrom->GetId(), nDos);
-            } else {
-                // only warn about anything non-critical (i.e. nDos == 0) in debug mode
-                LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- WARNING: invalid signature\n");
-            }
-            // Either our info or vote info could be outdated.
-            // In case our info is outdated, ask for an update,
-            mnodeman.AskForMN(pfrom, vote.masternodeOutpoint, connman);
-            // but there is nothing we can do if vote info itself is outdated
-            // (i.e. it was signed by a mn which changed its key),
-            // so just quit here.
-            return;
-        }
+        std::vector<CMessageSigCheck> vChecks;
+        vChecks.emplace_back(pvote->GetSignatureMessage(), pvote->vchSig, pvote->recoveredSigner, keyIDMasternode);
 
-        if(!UpdateLastVote(vote)) {
-            LogPrintf("MASTERNODEPAYMENTVOTE -- masternode already voted, masternode=%s\n", vote.masternodeOutpoint.ToStringShort());
-            return;
-        }
+        messageVerifier.Push(pfrom, vChecks, [this, pvote, &connman](CNode* pfrom) {
+            ProcessPaymentVote(pfrom, *pvote, connman);
+        });
+    }
+}
 
-        CTxDestination address1;
-        ExtractDestination(vote.payee, address1);
+void CMasternodePayments::ProcessPaymentVote(CNode* pfrom, const CMasternodePaymentVote& vote, CConnman& connman)
+{
+    uint256 nHash = vote.GetHash();
 
-        LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote: address=%s, nBlockHeight=%d, nHeight=%d, prevout=%s, hash=%s new\n",
-                    EncodeDestination(address1), vote.nBlockHeight, nCachedBlockHeight, vote.masternodeOutpoint.ToStringShort(), nHash.ToString());
+    masternode_info_t mnInfo;
+    if(!mnodeman.GetMasternodeInfo(vote.masternodeOutpoint, mnInfo)) {
+        // mn was not found, so we can't check vote, some info is probably missing
+        LogPrintf("MASTERNODEPAYMENTVOTE -- masternode is missing %s\n", vote.masternodeOutpoint.ToStringShort());
+        mnodeman.AskForMN(pfrom, vote.masternodeOutpoint, connman);
+        return;
+    }
 
-        if(AddOrUpdatePaymentVote(vote)){
-            vote.Relay(connman);
-            masternodeSync.BumpAssetLastTime("MASTERNODEPAYMENTVOTE");
+    int nDos = 0;
+    if(!vote.CheckSignature(mnInfo.pubKeyMasternode, nCachedBlockHeight, nDos)) {
+        if(nDos) {
+            LOCK(cs_main);
+            LogPrintf("MASTERNODEPAYMENTVOTE -- ERROR: invalid signature\n");
+            Misbehaving(pfrom->GetId(), nDos);
+        } else {
+            // only warn about anything non-critical (i.e. nDos == 0) in debug mode
+            LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- WARNING: invalid signature\n");
         }
+        // Either our info or vote info could be outdated.
+        // In case our info is outdated, ask for an update,
+        mnodeman.AskForMN(pfrom, vote.masternodeOutpoint, connman);
+        // but there is nothing we can do if vote info itself is outdated
+        // (i.e. it was signed by a mn which changed its key),
+        // so just quit here.
+        return;
+    }
+
+    if(!UpdateLastVote(vote)) {
+        LogPrintf("MASTERNODEPAYMENTVOTE -- masternode already voted, masternode=%s\n", vote.masternodeOutpoint.ToStringShort());
+        return;
+    }
+
+    CTxDestination address1;
+    ExtractDestination(vote.payee, address1);
+
+    LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote: address=%s, nBlockHeight=%d, nHeight=%d, prevout=%s, hash=%s new\n",
+                EncodeDestination(address1), vote.nBlockHeight, nCachedBlockHeight, vote.masternodeOutpoint.ToStringShort(), nHash.ToString());
+
+    if(AddOrUpdatePaymentVote(vote)){
+        vote.Relay(connman);
+        masternodeSync.BumpAssetLastTime("MASTERNODEPAYMENTVOTE");
     }
 }
 
@@ -271,13 +296,18 @@ uint256 CMasternodePaymentVote::GetSignatureHash() const
     return SerializeHash(*this);
 }
 
+std::string CMasternodePaymentVote::GetSignatureMessage() const
+{
+    return masternodeOutpoint.ToStringShort() +
+                boost::lexical_cast<std::string>(nBlockHeight) +
+                ScriptToAsmStr(payee);
+}
+
 bool CMasternodePaymentVote::Sign()
 {
     std::string strError;
 
-    std::string strMessage = masternodeOutpoint.ToStringShort() +
-                boost::lexical_cast<std::string>(nBlockHeight) +
-                ScriptToAsmStr(payee);
+    std::string strMessage = GetSignatureMessage();
 
     if(!CMessageSigner::SignMessage(strMessage, vchSig, activeMasternode.keyMasternode)) {
         LogPrintf("CMasternodePaymentVote::Sign -- SignMessage() failed\n");
@@ -333,7 +363,12 @@ bool CMasternodePayments::AddOrUpdatePaymentVote(const CMasternodePaymentVote& v
 
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
 
-    mapMasternodePaymentVotes[nVoteHash] = vote;
+    auto res = mapMasternodePaymentVotes.emplace(nVoteHash, vote);
+    if(res.second) {
+        mapVoteHashesByHeight[vote.nBlockHeight].push_back(nVoteHash);
+    } else {
+        res.first->second = vote;
+    }
 
     auto it = mapMasternodeBlocks.emplace(vote.nBlockHeight, CMasternodeBlockPayees(vote.nBlockHeight)).first;
     it->second.AddPayee(vote);
@@ -350,50 +385,69 @@ bool CMasternodePayments::HasVerifiedPaymentVote(const uint256& hashIn) const
     return it != mapMasternodePaymentVotes.end() && it->second.IsVerified();
 }
 
+void CMasternodeBlockPayees::UpdateBestPayee(size_t nIndex)
+{
+    if (nBestPayeeIndex < 0) {
+        nBestPayeeIndex = nIndex;
+        return;
+    }
+
+    int nVotes = vecPayees[nIndex].GetVoteCount();
+    int nBestVotes = vecPayees[nBestPayeeIndex].GetVoteCount();
+    if (nVotes > nBestVotes || (nVotes == nBestVotes && (int)nIndex < nBestPayeeIndex)) {
+        nBestPayeeIndex = nIndex;
+    }
+}
+
+void CMasternodeBlockPayees::RebuildTally()
+{
+    mapPayeeIndexes.clear();
+    nBestPayeeIndex = -1;
+    for (size_t i = 0; i < vecPayees.size(); i++) {
+        mapPayeeIndexes.emplace(vecPayees[i].GetPayee(), i);
+        UpdateBestPayee(i);
+    }
+}
+
 void CMasternodeBlockPayees::AddPayee(const CMasternodePaymentVote& vote)
 {
-    LOCK(cs_vecPayees);
+    AssertLockHeld(cs_mapMasternodeBlocks);
 
     uint256 nVoteHash = vote.GetHash();
 
-    for (auto& payee : vecPayees) {
-        if (payee.GetPayee() == vote.payee) {
-            payee.AddVoteHash(nVoteHash);
-            return;
-        }
+    size_t nIndex;
+    auto it = mapPayeeIndexes.find(vote.payee);
+    if (it != mapPayeeIndexes.end()) {
+        nIndex = it->second;
+        vecPayees[nIndex].AddVoteHash(nVoteHash);
+    } else {
+        nIndex = vecPayees.size();
+        mapPayeeIndexes.emplace(vote.payee, nIndex);
+        vecPayees.emplace_back(vote.payee, nVoteHash);
     }
-    CMasternodePayee payeeNew(vote.payee, nVoteHash);
-    vecPayees.push_back(payeeNew);
+    UpdateBestPayee(nIndex);
 }
 
 bool CMasternodeBlockPayees::GetBestPayee(CScript& payeeRet) const
 {
-    LOCK(cs_vecPayees);
+    AssertLockHeld(cs_mapMasternodeBlocks);
 
-    if(vecPayees.empty()) {
+    if(nBestPayeeIndex < 0) {
         LogPrint(BCLog::MNPAYMENTS, "CMasternodeBlockPayees::GetBestPayee -- ERROR: couldn't find any payee\n");
         return false;
     }
 
-    int nVotes = -1;
-    for (const auto& payee : vecPayees) {
-        if (payee.GetVoteCount() > nVotes) {
-            payeeRet = payee.GetPayee();
-            nVotes = payee.GetVoteCount();
-        }
-    }
-
-    return (nVotes > -1);
+    payeeRet = vecPayees[nBestPayeeIndex].GetPayee();
+    return true;
 }
 
 bool CMasternodeBlockPayees::HasPayeeWithVotes(const CScript& payeeIn, int nVotesReq) const
 {
-    LOCK(cs_vecPayees);
+    AssertLockHeld(cs_mapMasternodeBlocks);
 
-    for (const auto& payee : vecPayees) {
-        if (payee.GetVoteCount() >= nVotesReq && payee.GetPayee() == payeeIn) {
-            return true;
-        }
+    auto it = mapPayeeIndexes.find(payeeIn);
+    if (it != mapPayeeIndexes.end() && vecPayees[it->second].GetVoteCount() >= nVotesReq) {
+        return true;
     }
 
     LogPrint(BCLog::MNPAYMENTS, "CMasternodeBlockPayees::%s -- ERROR: couldn't find any payee with %d+ votes\n", __func__, nVotesReq);
@@ -402,34 +456,28 @@ bool CMasternodeBlockPayees::HasPayeeWithVotes(const CScript& payeeIn, int nVote
 
 bool CMasternodeBlockPayees::IsTransactionValid(const CTransaction& txNew) const
 {
-    LOCK(cs_vecPayees);
-
-    int nMaxSignatures = 0;
-    std::string strPayeesPossible = "";
+    AssertLockHeld(cs_mapMasternodeBlocks);
 
     CAmount blockReward = txNew.GetValueOut();
     CAmount nMasternodePayment = GetMasternodePayment(blockReward - GetDeveloperPayment(blockReward));
 
     //require at least MNPAYMENTS_SIGNATURES_REQUIRED signatures
 
-    for (const auto& payee : vecPayees) {
-        if (payee.GetVoteCount() >= nMaxSignatures) {
-            nMaxSignatures = payee.GetVoteCount();
+    // if we don't have at least MNPAYMENTS_SIGNATURES_REQUIRED signatures on a payee, approve whichever is the longest chain
+    if(nBestPayeeIndex < 0 || vecPayees[nBestPayeeIndex].GetVoteCount() < MNPAYMENTS_SIGNATURES_REQUIRED) return true;
+
+    for (const auto& txout : txNew.vout) {
+        auto it = mapPayeeIndexes.find(txout.scriptPubKey);
+        if (it != mapPayeeIndexes.end() && vecPayees[it->second].GetVoteCount() >= MNPAYMENTS_SIGNATURES_REQUIRED && nMasternodePayment == txout.nValue) {
+            LogPrint(BCLog::MNPAYMENTS, "CMasternodeBlockPayees::%s -- Found required payment\n", __func__);
+            return true;
         }
     }
 
-    // if we don't have at least MNPAYMENTS_SIGNATURES_REQUIRED signatures on a payee, approve whichever is the longest chain
-    if(nMaxSignatures < MNPAYMENTS_SIGNATURES_REQUIRED) return true;
+    std::string strPayeesPossible = "";
 
     for (const auto& payee : vecPayees) {
         if (payee.GetVoteCount() >= MNPAYMENTS_SIGNATURES_REQUIRED) {
-            for (const auto& txout : txNew.vout) {
-                if (payee.GetPayee() == txout.scriptPubKey && nMasternodePayment == txout.nValue) {
-                    LogPrint(BCLog::MNPAYMENTS, "CMasternodeBlockPayees::%s -- Found required payment\n", __func__);
-                    return true;
-                }
-            }
-
             CTxDestination address1;
             ExtractDestination(payee.GetPayee(), address1);
 
@@ -447,7 +495,7 @@ bool CMasternodeBlockPayees::IsTransactionValid(const CTransaction& txNew) const
 
 std::string CMasternodeBlockPayees::GetRequiredPaymentsString() const
 {
-    LOCK(cs_vecPayees);
+    AssertLockHeld(cs_mapMasternodeBlocks);
 
     std::string strRequiredPayments = "";
 
@@ -490,20 +538,18 @@ void CMasternodePayments::CheckAndRemove()
 
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
 
-    int nLimit = GetStorageLimit();
-
-    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.begin();
-    while(it != mapMasternodePaymentVotes.end()) {
-        CMasternodePaymentVote vote = (*it).second;
+    int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
 
-        if(nCachedBlockHeight - vote.nBlockHeight > nLimit) {
-            LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::CheckAndRemove -- Removing old Masternode payment: nBlockHeight=%d\n", vote.nBlockHeight);
-            mapMasternodePaymentVotes.erase(it++);
-            mapMasternodeBlocks.erase(vote.nBlockHeight);
-        } else {
-            ++it;
+    // drop whole heights at once, oldest first
+    auto it = mapVoteHashesByHeight.begin();
+    while(it != mapVoteHashesByHeight.end() && it->first < nFirstBlock) {
+        LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::CheckAndRemove -- Removing old Masternode payments: nBlockHeight=%d, votes=%d\n", it->first, it->second.size());
+        for (const auto& nVoteHash : it->second) {
+            mapMasternodePaymentVotes.erase(nVoteHash);
         }
+        it = mapVoteHashesByHeight.erase(it);
     }
+    mapMasternodeBlocks.erase(mapMasternodeBlocks.begin(), mapMasternodeBlocks.lower_bound(nFirstBlock));
     LogPrintf("CMasternodePayments::CheckAndRemove -- %s\n", ToString());
 }
 
@@ -709,11 +755,9 @@ bool CMasternodePaymentVote::CheckSignature(const CPubKey& pubKeyMasternode, int
     nDos = 0;
     std::string strError = "";
 
-    std::string strMessage = masternodeOutpoint.ToStringShort() +
-                boost::lexical_cast<std::string>(nBlockHeight) +
-                ScriptToAsmStr(payee);
+    std::string strMessage = GetSignatureMessage();
 
-    if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if (!CMessageSigner::VerifyMessageCached(pubKeyMasternode, vchSig, strMessage, strError, &recoveredSigner)) {
         // Only ban for future block vote when we are already synced.
         // Otherwise it could be the case when MN which signed this vote is using another key now
         // and we have no idea about the old one.
@@ -797,7 +841,8 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
         pindex = pindex->pprev;
     }
 
-    auto it = mapMasternodeBlocks.begin();
+    // heights below nLimit are about to be removed, no need to ask for them
+    auto it = mapMasternodeBlocks.lower_bound(nCachedBlockHeight - nLimit);
 
     while(it != mapMasternodeBlocks.end()) {
         int nTotalVotes = 0;
@@ -25,8 +25,8 @@ static const int MNPAYMENTS_SIGNATURES_TOTAL            = 10;
 // V2 - Newest protocol version
 static const int MIN_MASTERNODE_PAYMENT_PROTO_VERSION_1 = 70210;
 
-extern CCriticalSection cs_vecPayees;
 extern CCriticalSection cs_mapMasternodeBlocks;
+extern CCriticalSection cs_mapMasternodePaymentVotes;
 
 extern CMasternodePayments mnpayments;
 
@@ -69,18 +69,31 @@ public:
     int GetVoteCount() const { return vecVoteHashes.size(); }
 };
 
-// Keep track of votes for payees from masternodes
+// Keep track of votes for payees from masternodes,
+// the tally is kept up to date as votes come in so that checking a block is a lookup.
+// Guarded by cs_mapMasternodeBlocks like the map holding it.
 class CMasternodeBlockPayees
 {
+private:
+    std::map<CScript, size_t> mapPayeeIndexes; ///< Payee - Index in vecPayees
+    int nBestPayeeIndex; ///< Payee with most votes, the first one in vecPayees on a tie, -1 if none
+
+    void UpdateBestPayee(size_t nIndex);
+    void RebuildTally();
+
 public:
     int nBlockHeight;
     std::vector<CMasternodePayee> vecPayees;
 
     CMasternodeBlockPayees() :
+        mapPayeeIndexes(),
+        nBestPayeeIndex(-1),
         nBlockHeight(0),
         vecPayees()
         {}
     CMasternodeBlockPayees(int nBlockHeightIn) :
+        mapPayeeIndexes(),
+        nBestPayeeIndex(-1),
         nBlockHeight(nBlockHeightIn),
         vecPayees()
         {}
@@ -91,6 +104,9 @@ public:
     inline void SerializationOp(Stream& s, Operation ser_action) {
         READWRITE(nBlockHeight);
         READWRITE(vecPayees);
+        if (ser_action.ForRead()) {
+            RebuildTally();
+        }
     }
 
     void AddPayee(const CMasternodePaymentVote& vote);
@@ -111,6 +127,8 @@ public:
     int nBlockHeight;
     CScript payee;
     std::vector<unsigned char> vchSig;
+    // not serialized, filled in by CMessageVerifier
+    CRecoveredSigner recoveredSigner;
 
     CMasternodePaymentVote() :
         masternodeOutpoint(),
@@ -140,6 +158,7 @@ public:
 
     uint256 GetHash() const;
     uint256 GetSignatureHash() const;
+    std::string GetSignatureMessage() const;
 
     bool Sign();
     bool CheckSignature(const CPubKey& pubKeyMasternode, int nValidationHeight, int &nDos) const;
@@ -169,6 +188,12 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    /// Hashes of mapMasternodePaymentVotes by the height they vote for, so that old heights go a bucket at a time
+    std::map<int, std::vector<uint256> > mapVoteHashesByHeight;
+
+    /// Continue handling a MASTERNODEPAYMENTVOTE in range and valid once CMessageVerifier recovered its signer
+    void ProcessPaymentVote(CNode* pfrom, const CMasternodePaymentVote& vote, CConnman& connman);
+
 public:
     std::map<uint256, CMasternodePaymentVote> mapMasternodePaymentVotes;
     std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
@@ -181,8 +206,15 @@ public:
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
+        LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
         READWRITE(mapMasternodePaymentVotes);
         READWRITE(mapMasternodeBlocks);
+        if (ser_action.ForRead()) {
+            mapVoteHashesByHeight.clear();
+            for (const auto& pair : mapMasternodePaymentVotes) {
+                mapVoteHashesByHeight[pair.second.nBlockHeight].push_back(pair.first);
+            }
+        }
     }
 
     void Clear();
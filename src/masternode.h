@@ -6,6 +6,7 @@
 #define MASTERNODE_H
 
 #include <key.h>
+#include <messagesigner.h>
 #include <net.h>
 #include <timedata.h>
 #include <validation.h>
@@ -41,6 +42,8 @@ public:
     int64_t sigTime{}; //mnb message times
     std::vector<unsigned char> vchSig{};
     uint32_t nDaemonVersion{DEFAULT_DAEMON_VERSION};
+    // not serialized, filled in by CMessageVerifier
+    CRecoveredSigner recoveredSigner{};
 
     CMasternodePing() = default;
 
@@ -61,6 +64,7 @@ public:
 
     uint256 GetHash() const;
     uint256 GetSignatureHash() const;
+    std::string GetSignatureMessage() const;
 
     bool IsExpired() const { return GetAdjustedTime() - sigTime > MASTERNODE_NEW_START_REQUIRED_SECONDS; }
 
@@ -286,6 +290,8 @@ class CMasternodeBroadcast : public CMasternode
 public:
 
     bool fRecovery;
+    // not serialized, filled in by CMessageVerifier
+    CRecoveredSigner recoveredSigner;
 
     CMasternodeBroadcast() : CMasternode(), fRecovery(false) {}
     CMasternodeBroadcast(const CMasternode& mn) : CMasternode(mn), fRecovery(false) {}
@@ -312,6 +318,7 @@ public:
 
     uint256 GetHash() const;
     uint256 GetSignatureHash() const;
+    std::string GetSignatureMessage() const;
 
     /// Create Masternode broadcast, needs to be relayed manually after that
     static bool Create(const COutPoint& outpoint, const CService& service, const CKey& keyCollateralAddressNew, const CPubKey& pubKeyCollateralAddressNew, const CKey& keyMasternodeNew, const CPubKey& pubKeyMasternodeNew, std::string &strErrorRet, CMasternodeBroadcast &mnbRet);
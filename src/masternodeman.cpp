@@ -8,11 +8,14 @@
 #include <addrman.h>
 #include <alert.h>
 #include <clientversion.h>
+#include <hash.h>
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 #include <messagesigner.h>
+#include <messageverifier.h>
 #include <netfulfilledman.h>
 #include <netmessagemaker.h>
+#include <random.h>
 #ifdef ENABLE_WALLET
 #include <privatesend-client.h>
 #endif // ENABLE_WALLET
@@ -27,15 +30,6 @@ CMasternodeMan mnodeman;
 const std::string CMasternodeMan::SERIALIZATION_VERSION_STRING = "CMasternodeMan-Version-8";
 const int CMasternodeMan::LAST_PAID_SCAN_BLOCKS = 100;
 
-struct CompareLastPaidBlock
-{
-    bool operator()(const std::pair<int, const CMasternode*>& t1,
-                    const std::pair<int, const CMasternode*>& t2) const
-    {
-        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->outpoint < t2.second->outpoint);
-    }
-};
-
 struct CompareScoreMN
 {
     bool operator()(const std::pair<arith_uint256, const CMasternode*>& t1,
@@ -55,9 +49,42 @@ struct CompareByAddr
     }
 };
 
+SaltedKeyIDHasher::SaltedKeyIDHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+size_t SaltedKeyIDHasher::operator()(const CKeyID& id) const
+{
+    return CSipHasher(k0, k1).Write(id.begin(), id.size()).Finalize();
+}
+
+SaltedServiceHasher::SaltedServiceHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+size_t SaltedServiceHasher::operator()(const CService& addr) const
+{
+    std::vector<unsigned char> vchKey = addr.GetKey();
+    return CSipHasher(k0, k1).Write(vchKey.data(), vchKey.size()).Finalize();
+}
+
+template <typename Index, typename Key>
+static void EraseIndexEntry(Index& index, const Key& key, const COutPoint& outpoint)
+{
+    auto range = index.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == outpoint) {
+            index.erase(it);
+            return;
+        }
+    }
+}
+
 CMasternodeMan::CMasternodeMan():
     cs(),
     mapMasternodes(),
+    mapMasternodesByPubKey(),
+    mapMasternodesByPayee(),
+    mapMasternodesByAddr(),
+    mapMasternodeScoresCache(SCORES_CACHE_SIZE),
+    pListSnapshot(),
+    fListSnapshotStale(true),
     mAskedUsForMasternodeList(),
     mWeAskedForMasternodeList(),
     mWeAskedForMasternodeListEntry(),
@@ -78,9 +105,51 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.outpoint] = mn;
+    IndexMasternode(mn);
+    mapMasternodeScoresCache.clear();
     return true;
 }
 
+void CMasternodeMan::IndexMasternode(const CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    mapMasternodesByPubKey.emplace(mn.pubKeyMasternode.GetID(), mn.outpoint);
+    mapMasternodesByPayee.emplace(mn.pubKeyCollateralAddress.GetID(), mn.outpoint);
+    mapMasternodesByAddr.emplace(mn.addr, mn.outpoint);
+    setMasternodesByLastPaid.emplace(mn.nBlockLastPaid, mn.outpoint);
+    ListChanged();
+}
+
+void CMasternodeMan::UnindexMasternode(const CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    EraseIndexEntry(mapMasternodesByPubKey, mn.pubKeyMasternode.GetID(), mn.outpoint);
+    EraseIndexEntry(mapMasternodesByPayee, mn.pubKeyCollateralAddress.GetID(), mn.outpoint);
+    EraseIndexEntry(mapMasternodesByAddr, mn.addr, mn.outpoint);
+    setMasternodesByLastPaid.erase(std::make_pair(mn.nBlockLastPaid, mn.outpoint));
+    ListChanged();
+}
+
+void CMasternodeMan::RebuildIndexes()
+{
+    AssertLockHeld(cs);
+    mapMasternodesByPubKey.clear();
+    mapMasternodesByPayee.clear();
+    mapMasternodesByAddr.clear();
+    setMasternodesByLastPaid.clear();
+    for (const auto& mnpair : mapMasternodes) {
+        IndexMasternode(mnpair.second);
+    }
+    mapMasternodeScoresCache.clear();
+    ListChanged();
+}
+
+void CMasternodeMan::ListChanged()
+{
+    AssertLockHeld(cs);
+    fListSnapshotStale = true;
+}
+
 void CMasternodeMan::AskForMN(CNode* pnode, const COutPoint& outpoint, CConnman& connman)
 {
     if(!pnode) return;
@@ -122,6 +191,7 @@ bool CMasternodeMan::AllowMixing(const COutPoint &outpoint)
     nDsqCount++;
     pmn->nLastDsq = nDsqCount;
     pmn->fAllowMixingTx = true;
+    ListChanged();
 
     return true;
 }
@@ -134,6 +204,7 @@ bool CMasternodeMan::DisallowMixing(const COutPoint &outpoint)
         return false;
     }
     pmn->fAllowMixingTx = false;
+    ListChanged();
 
     return true;
 }
@@ -146,6 +217,7 @@ bool CMasternodeMan::PoSeBan(const COutPoint &outpoint)
         return false;
     }
     pmn->PoSeBan();
+    ListChanged();
 
     return true;
 }
@@ -157,7 +229,11 @@ void CMasternodeMan::Check()
     for (auto& mnpair : mapMasternodes) {
         // NOTE: internally it checks only every MASTERNODE_CHECK_SECONDS seconds
         // since the last time, so expect some MNs to skip this
+        int nActiveStateOld = mnpair.second.nActiveState;
         mnpair.second.Check();
+        if (mnpair.second.nActiveState != nActiveStateOld) {
+            ListChanged();
+        }
     }
 }
 
@@ -189,6 +265,8 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
                 mWeAskedForMasternodeListEntry.erase(it->first);
 
                 // and finally remove it from the list
+                UnindexMasternode(it->second);
+                mapMasternodeScoresCache.clear();
                 mapMasternodes.erase(it++);
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
@@ -341,6 +419,12 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    mapMasternodesByPubKey.clear();
+    mapMasternodesByPayee.clear();
+    mapMasternodesByAddr.clear();
+    setMasternodesByLastPaid.clear();
+    mapMasternodeScoresCache.clear();
+    ListChanged();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -365,12 +449,11 @@ int CMasternodeMan::CountMasternodes(int nProtocolVersion)
 
 int CMasternodeMan::CountEnabled(int nProtocolVersion)
 {
-    LOCK(cs);
     int nCount = 0;
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinMasternodePaymentsProto() : nProtocolVersion;
 
-    for (const auto& mnpair : mapMasternodes) {
-        if(mnpair.second.nProtocolVersion < nProtocolVersion || !mnpair.second.IsEnabled()) continue;
+    for (const auto& mn : *GetListSnapshot()) {
+        if(mn.nProtocolVersion < nProtocolVersion || !mn.IsEnabled()) continue;
         nCount++;
     }
 
@@ -424,6 +507,43 @@ CMasternode* CMasternodeMan::Find(const COutPoint &outpoint)
     return it == mapMasternodes.end() ? NULL : &(it->second);
 }
 
+CMasternode* CMasternodeMan::FindByPubKey(const CPubKey& pubKeyMasternode)
+{
+    LOCK(cs);
+    CMasternode* pmn = NULL;
+    auto range = mapMasternodesByPubKey.equal_range(pubKeyMasternode.GetID());
+    for (auto it = range.first; it != range.second; ++it) {
+        // several masternodes may share a key, pick the one a scan of the list would meet first
+        if (pmn && pmn->outpoint < it->second) continue;
+        CMasternode* pmnCandidate = Find(it->second);
+        if (pmnCandidate && pmnCandidate->pubKeyMasternode == pubKeyMasternode) {
+            pmn = pmnCandidate;
+        }
+    }
+    return pmn;
+}
+
+CMasternode* CMasternodeMan::FindByPayee(const CScript& payee)
+{
+    LOCK(cs);
+    // masternodes are only ever paid to the P2PKH script of their collateral key
+    CTxDestination dest;
+    if (!ExtractDestination(payee, dest)) return NULL;
+    const CKeyID* keyID = boost::get<CKeyID>(&dest);
+    if (!keyID || GetScriptForDestination(*keyID) != payee) return NULL;
+
+    CMasternode* pmn = NULL;
+    auto range = mapMasternodesByPayee.equal_range(*keyID);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (pmn && pmn->outpoint < it->second) continue;
+        CMasternode* pmnCandidate = Find(it->second);
+        if (pmnCandidate) {
+            pmn = pmnCandidate;
+        }
+    }
+    return pmn;
+}
+
 bool CMasternodeMan::Get(const COutPoint& outpoint, CMasternode& masternodeRet)
 {
     // Theses mutexes are recursive so double locking by the same thread is safe.
@@ -451,26 +571,51 @@ bool CMasternodeMan::GetMasternodeInfo(const COutPoint& outpoint, masternode_inf
 bool CMasternodeMan::GetMasternodeInfo(const CPubKey& pubKeyMasternode, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (const auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
-        }
+    CMasternode* pmn = FindByPubKey(pubKeyMasternode);
+    if (!pmn) {
+        return false;
     }
-    return false;
+    mnInfoRet = pmn->GetInfo();
+    return true;
 }
 
 bool CMasternodeMan::GetMasternodeInfo(const CScript& payee, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (const auto& mnpair : mapMasternodes) {
-        CScript scriptCollateralAddress = GetScriptForDestination(mnpair.second.pubKeyCollateralAddress.GetID());
-        if (scriptCollateralAddress == payee) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
+    CMasternode* pmn = FindByPayee(payee);
+    if (!pmn) {
+        return false;
+    }
+    mnInfoRet = pmn->GetInfo();
+    return true;
+}
+
+std::shared_ptr<const CMasternodeMan::list_snapshot_t> CMasternodeMan::GetListSnapshot()
+{
+    if (!fListSnapshotStale) {
+        std::shared_ptr<const list_snapshot_t> pSnapshot = std::atomic_load(&pListSnapshot);
+        if (pSnapshot) return pSnapshot;
+    }
+
+    // writers hold cs too, so nothing changes while the copy is made
+    LOCK(cs);
+    if (fListSnapshotStale || !pListSnapshot) {
+        auto pSnapshot = std::make_shared<list_snapshot_t>();
+        pSnapshot->reserve(mapMasternodes.size());
+        for (const auto& mnpair : mapMasternodes) {
+            pSnapshot->push_back(mnpair.second);
         }
+        std::atomic_store(&pListSnapshot, std::shared_ptr<const list_snapshot_t>(std::move(pSnapshot)));
+        fListSnapshotStale = false;
+    }
+    return pListSnapshot;
+}
+
+void CMasternodeMan::ForEachMasternode(const std::function<void(const CMasternode&)>& func)
+{
+    for (const auto& mn : *GetListSnapshot()) {
+        func(mn);
     }
-    return false;
 }
 
 bool CMasternodeMan::Has(const COutPoint& outpoint)
@@ -482,12 +627,12 @@ bool CMasternodeMan::Has(const COutPoint& outpoint)
 //
 // Deterministically select the oldest/best masternode to pay on the network
 //
-bool CMasternodeMan::GetNextMasternodeInQueueForPayment(bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet)
+bool CMasternodeMan::GetNextMasternodeInQueueForPayment(bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet, bool fCountAll)
 {
-    return GetNextMasternodeInQueueForPayment(nCachedBlockHeight, fFilterSigTime, nCountRet, mnInfoRet);
+    return GetNextMasternodeInQueueForPayment(nCachedBlockHeight, fFilterSigTime, nCountRet, mnInfoRet, fCountAll);
 }
 
-bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet)
+bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet, bool fCountAll)
 {
     mnInfoRet = masternode_info_t();
     nCountRet = 0;
@@ -500,62 +645,63 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
     // Need LOCK2 here to ensure consistent locking order because the GetBlockHash call below locks cs_main
     LOCK2(cs_main,cs);
 
-    std::vector<std::pair<int, const CMasternode*> > vecMasternodeLastPaid;
+    std::vector<const CMasternode*> vecMasternodeLastPaid;
 
     /*
-        Make a vector with all of the last paid times
+        Walk the payment queue from the least recently paid masternode on
     */
 
     int nMnCount = CountMasternodes();
+    // Look at 1/10 of the oldest nodes (by last payment) but at least one
+    size_t nTenthNetwork = std::max(nMnCount/10, 1);
+    // once the candidates are collected and this many qualify, the fallback below can't trigger anymore
+    int nCountEnough = fFilterSigTime ? nMnCount/3 : 0;
 
-    for (const auto& mnpair : mapMasternodes) {
-        if(!mnpair.second.IsValidForPayment()) continue;
+    for (const auto& entry : setMasternodesByLastPaid) {
+        const CMasternode& mn = mapMasternodes.at(entry.second);
+
+        if(!mn.IsValidForPayment()) continue;
 
         //check protocol version
-        if(mnpair.second.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
+        if(mn.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
 
         //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
-        if(mnpayments.IsScheduled(mnpair.second, nBlockHeight)) continue;
+        if(mnpayments.IsScheduled(mn, nBlockHeight)) continue;
 
         //it's too new, wait for a cycle
-        if(fFilterSigTime && mnpair.second.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
+        if(fFilterSigTime && mn.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
 
         //make sure it has at least as many confirmations as there are masternodes
-        if(GetUTXOConfirmations(mnpair.first) < nMnCount) continue;
+        if(GetUTXOConfirmations(mn.outpoint) < nMnCount) continue;
 
-        vecMasternodeLastPaid.push_back(std::make_pair(mnpair.second.GetLastPaidBlock(), &mnpair.second));
+        if(vecMasternodeLastPaid.size() < nTenthNetwork) {
+            vecMasternodeLastPaid.push_back(&mn);
+        }
+        nCountRet++;
+        if(!fCountAll && nCountRet >= nCountEnough && vecMasternodeLastPaid.size() == nTenthNetwork) break;
     }
 
-    nCountRet = (int)vecMasternodeLastPaid.size();
-
     //when the network is in the process of upgrading, don't penalize nodes that recently restarted
     if(fFilterSigTime && nCountRet < nMnCount/3)
-        return GetNextMasternodeInQueueForPayment(nBlockHeight, false, nCountRet, mnInfoRet);
-
-    // Sort them low to high
-    sort(vecMasternodeLastPaid.begin(), vecMasternodeLastPaid.end(), CompareLastPaidBlock());
+        return GetNextMasternodeInQueueForPayment(nBlockHeight, false, nCountRet, mnInfoRet, fCountAll);
 
     uint256 blockHash;
     if(!GetBlockHash(blockHash, nBlockHeight - 101)) {
         LogPrintf("CMasternode::GetNextMasternodeInQueueForPayment -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", nBlockHeight - 101);
         return false;
     }
-    // Look at 1/10 of the oldest nodes (by last payment), calculate their scores and pay the best one
+    // Calculate the scores of the oldest nodes (by last payment) and pay the best one
     //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
     //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
     //  -- (chance per block * chances before IsScheduled will fire)
-    int nTenthNetwork = nMnCount/10;
-    int nCountTenth = 0;
     arith_uint256 nHighest = 0;
     const CMasternode *pBestMasternode = NULL;
-    for (const auto& s : vecMasternodeLastPaid) {
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+    for (const auto& pmn : vecMasternodeLastPaid) {
+        arith_uint256 nScore = pmn->CalculateScore(blockHash);
         if(nScore > nHighest){
             nHighest = nScore;
-            pBestMasternode = s.second;
+            pBestMasternode = pmn;
         }
-        nCountTenth++;
-        if(nCountTenth >= nTenthNetwork) break;
     }
     if (pBestMasternode) {
         mnInfoRet = pBestMasternode->GetInfo();
@@ -565,7 +711,7 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
 
 masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion)
 {
-    LOCK(cs);
+    std::shared_ptr<const list_snapshot_t> pSnapshot = GetListSnapshot();
 
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinMasternodePaymentsProto() : nProtocolVersion;
 
@@ -577,8 +723,8 @@ masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint
 
     // fill a vector of pointers
     std::vector<const CMasternode*> vpMasternodesShuffled;
-    for (const auto& mnpair : mapMasternodes) {
-        vpMasternodesShuffled.push_back(&mnpair.second);
+    for (const auto& mn : *pSnapshot) {
+        vpMasternodesShuffled.push_back(&mn);
     }
 
     FastRandomContextDash insecure_rand;
@@ -618,6 +764,14 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     if (mapMasternodes.empty())
         return false;
 
+    // the same block is ranked for every payment vote and lock vote referring to it
+    const auto key = std::make_pair(nBlockHash, nMinProtocol);
+    const score_pair_vec_t* pvecCached = mapMasternodeScoresCache.get(key);
+    if (pvecCached) {
+        vecMasternodeScoresRet = *pvecCached;
+        return !vecMasternodeScoresRet.empty();
+    }
+
     // calculate scores
     for (const auto& mnpair : mapMasternodes) {
         if (mnpair.second.nProtocolVersion >= nMinProtocol) {
@@ -626,6 +780,7 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     }
 
     sort(vecMasternodeScoresRet.rbegin(), vecMasternodeScoresRet.rend(), CompareScoreMN());
+    mapMasternodeScoresCache.insert(key, vecMasternodeScoresRet);
     return !vecMasternodeScoresRet.empty();
 }
 
@@ -783,65 +938,62 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
 
     if (strCommand == NetMsgType::MNANNOUNCE) { //Masternode Broadcast
 
-        CMasternodeBroadcast mnb;
-        vRecv >> mnb;
+        auto pmnb = std::make_shared<CMasternodeBroadcast>();
+        vRecv >> *pmnb;
 
-        pfrom->setAskFor.erase(mnb.GetHash());
+        uint256 hash = pmnb->GetHash();
 
-        if(!masternodeSync.IsBlockchainSynced()) return;
+        pfrom->RemoveAskFor(hash);
 
-        LogPrint(BCLog::MASTERNODE, "MNANNOUNCE -- Masternode announce, masternode=%s\n", mnb.outpoint.ToStringShort());
+        if(!masternodeSync.IsBlockchainSynced()) return;
 
-        int nDos = 0;
+        LogPrint(BCLog::MASTERNODE, "MNANNOUNCE -- Masternode announce, masternode=%s\n", pmnb->outpoint.ToStringShort());
 
-        if (CheckMnbAndUpdateMasternodeList(pfrom, mnb, nDos, connman)) {
-            // use announced Masternode as a peer
-            connman.AddNewAddress(CAddress(mnb.addr, NODE_NETWORK), pfrom->addr, 2*60*60);
-        } else if(nDos > 0) {
-            LOCK(cs_main);
-            Misbehaving(pfrom->GetId(), nDos);
+        // recover the signers of new broadcasts off this thread, seen ones don't get their signatures checked
+        std::vector<CMessageSigCheck> vChecks;
+        {
+            LOCK(cs);
+            if(!mapSeenMasternodeBroadcast.count(hash)) {
+                vChecks.emplace_back(pmnb->GetSignatureMessage(), pmnb->vchSig, pmnb->recoveredSigner, pmnb->pubKeyCollateralAddress.GetID());
+                vChecks.emplace_back(pmnb->lastPing.GetSignatureMessage(), pmnb->lastPing.vchSig, pmnb->lastPing.recoveredSigner, pmnb->pubKeyMasternode.GetID());
+            }
         }
-    } else if (strCommand == NetMsgType::MNPING) { //Masternode Ping
-
-        CMasternodePing mnp;
-        vRecv >> mnp;
-
-        uint256 nHash = mnp.GetHash();
-
-        pfrom->setAskFor.erase(nHash);
 
-        if(!masternodeSync.IsBlockchainSynced()) return;
+        messageVerifier.Push(pfrom, vChecks, [this, pmnb, &connman](CNode* pfrom) {
+            ProcessBroadcast(pfrom, *pmnb, connman);
+        });
 
-        LogPrint(BCLog::MASTERNODE, "MNPING -- Masternode ping, masternode=%s\n", mnp.masternodeOutpoint.ToStringShort());
+    } else if (strCommand == NetMsgType::MNPING) { //Masternode Ping
 
-        // Need LOCK2 here to ensure consistent locking order because the CheckAndUpdate call below locks cs_main
-        LOCK2(cs_main, cs);
+        auto pmnp = std::make_shared<CMasternodePing>();
+        vRecv >> *pmnp;
 
-        if(mapSeenMasternodePing.count(nHash)) return; //seen
-        mapSeenMasternodePing.insert(std::make_pair(nHash, mnp));
+        uint256 nHash = pmnp->GetHash();
 
-        LogPrint(BCLog::MASTERNODE, "MNPING -- Masternode ping, masternode=%s new\n", mnp.masternodeOutpoint.ToStringShort());
+        pfrom->RemoveAskFor(nHash);
 
-        // see if we have this Masternode
-        CMasternode* pmn = Find(mnp.masternodeOutpoint);
+        if(!masternodeSync.IsBlockchainSynced()) return;
 
-        // too late, new MNANNOUNCE is required
-        if(pmn && pmn->IsNewStartRequired()) return;
+        LogPrint(BCLog::MASTERNODE, "MNPING -- Masternode ping, masternode=%s\n", pmnp->masternodeOutpoint.ToStringShort());
 
-        int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        {
+            LOCK(cs);
+            if(mapSeenMasternodePing.count(nHash)) return; //seen
+        }
 
-        if(nDos > 0) {
-            // if anything significant failed, mark that node
-            Misbehaving(pfrom->GetId(), nDos);
-        } else if(pmn != NULL) {
-            // nothing significant failed, mn is a known one too
-            return;
+        // the ping is expected to be signed by the masternode key we know, if any
+        CKeyID keyIDMasternode;
+        masternode_info_t mnInfo;
+        if(GetMasternodeInfo(pmnp->masternodeOutpoint, mnInfo)) {
+            keyIDMasternode = mnInfo.pubKeyMasternode.GetID();
         }
 
-        // something significant is broken or mn is unknown,
-        // we might have to ask for a masternode entry once
-        AskForMN(pfrom, mnp.masternodeOutpoint, connman);
+        std::vector<CMessageSigCheck> vChecks;
+        vChecks.emplace_back(pmnp->GetSignatureMessage(), pmnp->vchSig, pmnp->recoveredSigner, keyIDMasternode);
+
+        messageVerifier.Push(pfrom, vChecks, [this, pmnp, &connman](CNode* pfrom) {
+            ProcessPing(pfrom, *pmnp, connman);
+        });
 
     } else if (strCommand == NetMsgType::DSEG) { //Get Masternode list or specific entry
         // Ignore such requests until we are fully synced.
@@ -869,7 +1021,7 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         CMasternodeVerification mnv;
         vRecv >> mnv;
 
-        pfrom->setAskFor.erase(mnv.GetHash());
+        pfrom->RemoveAskFor(mnv.GetHash());
 
         if(!masternodeSync.IsMasternodeListSynced()) return;
 
@@ -1233,7 +1385,18 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
 
         std::string strMessage1 = strprintf("%s%d%s", pnode->addr.ToString(false), mnv.nonce, blockHash.ToString());
 
-        for (auto& mnpair : mapMasternodes) {
+        // visit the masternodes at this address in list order
+        std::vector<COutPoint> vecOutpoints;
+        auto range = mapMasternodesByAddr.equal_range(pnode->addr);
+        for (auto it = range.first; it != range.second; ++it) {
+            vecOutpoints.push_back(it->second);
+        }
+        std::sort(vecOutpoints.begin(), vecOutpoints.end());
+
+        for (const auto& outpoint : vecOutpoints) {
+            auto mnit = mapMasternodes.find(outpoint);
+            if(mnit == mapMasternodes.end()) continue;
+            auto& mnpair = *mnit;
             if(CAddress(mnpair.second.addr, NODE_NETWORK) == pnode->addr) {
                 bool fFound = false;
                 fFound = CMessageSigner::VerifyMessage(mnpair.second.pubKeyMasternode, mnv.vchSig1, strMessage1, strError);
@@ -1242,6 +1405,7 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
                     prealMasternode = &mnpair.second;
                     if(!mnpair.second.IsPoSeVerified()) {
                         mnpair.second.DecreasePoSeBanScore();
+                        ListChanged();
                     }
                     netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
 
@@ -1289,6 +1453,7 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         // increase ban score for everyone else
         for (const auto& pmn : vpMasternodesToBan) {
             pmn->IncreasePoSeBanScore();
+            ListChanged();
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyReply -- increased PoSe ban score for %s addr %s, new score %d\n",
                         prealMasternode->outpoint.ToStringShort(), pnode->addr.ToString(), pmn->nPoSeBanScore);
         }
@@ -1383,6 +1548,7 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
 
         if(!pmn1->IsPoSeVerified()) {
             pmn1->DecreasePoSeBanScore();
+            ListChanged();
         }
         mnv.Relay();
 
@@ -1394,6 +1560,7 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
         for (auto& mnpair : mapMasternodes) {
             if(mnpair.second.addr != mnv.addr || mnpair.first == mnv.masternodeOutpoint1) continue;
             mnpair.second.IncreasePoSeBanScore();
+            ListChanged();
             nCount++;
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
                         mnpair.first.ToStringShort(), mnpair.second.addr.ToString(), mnpair.second.nPoSeBanScore);
@@ -1417,6 +1584,55 @@ std::string CMasternodeMan::ToString() const
     return info.str();
 }
 
+void CMasternodeMan::ProcessBroadcast(CNode* pfrom, const CMasternodeBroadcast& mnb, CConnman& connman)
+{
+    int nDos = 0;
+
+    if (CheckMnbAndUpdateMasternodeList(pfrom, mnb, nDos, connman)) {
+        // use announced Masternode as a peer
+        connman.AddNewAddress(CAddress(mnb.addr, NODE_NETWORK), pfrom->addr, 2*60*60);
+    } else if(nDos > 0) {
+        LOCK(cs_main);
+        Misbehaving(pfrom->GetId(), nDos);
+    }
+}
+
+void CMasternodeMan::ProcessPing(CNode* pfrom, CMasternodePing& mnp, CConnman& connman)
+{
+    uint256 nHash = mnp.GetHash();
+
+    // Need LOCK2 here to ensure consistent locking order because the CheckAndUpdate call below locks cs_main
+    LOCK2(cs_main, cs);
+
+    if(mapSeenMasternodePing.count(nHash)) return; //seen
+    mapSeenMasternodePing.insert(std::make_pair(nHash, mnp));
+
+    LogPrint(BCLog::MASTERNODE, "MNPING -- Masternode ping, masternode=%s new\n", mnp.masternodeOutpoint.ToStringShort());
+
+    // see if we have this Masternode
+    CMasternode* pmn = Find(mnp.masternodeOutpoint);
+
+    // too late, new MNANNOUNCE is required
+    if(pmn && pmn->IsNewStartRequired()) return;
+
+    int nDos = 0;
+    bool fUpdated = mnp.CheckAndUpdate(pmn, false, nDos, connman);
+    if(pmn) ListChanged();
+    if(fUpdated) return;
+
+    if(nDos > 0) {
+        // if anything significant failed, mark that node
+        Misbehaving(pfrom->GetId(), nDos);
+    } else if(pmn != NULL) {
+        // nothing significant failed, mn is a known one too
+        return;
+    }
+
+    // something significant is broken or mn is unknown,
+    // we might have to ask for a masternode entry once
+    AskForMN(pfrom, mnp.masternodeOutpoint, connman);
+}
+
 bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBroadcast mnb, int& nDos, CConnman& connman)
 {
     // Need to lock cs_main here to ensure consistent locking order because the SimpleCheck call below locks cs_main
@@ -1472,7 +1688,16 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         CMasternode* pmn = Find(mnb.outpoint);
         if(pmn) {
             CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-            if(!mnb.Update(pmn, nDos, connman)) {
+            // a newer broadcast may move the masternode to another key or address
+            int nProtocolVersionOld = pmn->nProtocolVersion;
+            UnindexMasternode(*pmn);
+            bool fUpdated = mnb.Update(pmn, nDos, connman);
+            IndexMasternode(*pmn);
+            // scores are filtered by protocol version
+            if(pmn->nProtocolVersion != nProtocolVersionOld) {
+                mapMasternodeScoresCache.clear();
+            }
+            if(!fUpdated) {
                 LogPrint(BCLog::MASTERNODE, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- Update() failed, masternode=%s\n", mnb.outpoint.ToStringShort());
                 return false;
             }
@@ -1525,7 +1750,14 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
                             __func__, nCachedBlockHeight, nLastRunBlockHeight, nMaxBlocksToScanBack);
 
     for (auto& mnpair : mapMasternodes) {
+        int nBlockLastPaidOld = mnpair.second.nBlockLastPaid;
         mnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+        if (mnpair.second.nBlockLastPaid != nBlockLastPaidOld) {
+            // move it back in the payment queue
+            setMasternodesByLastPaid.erase(std::make_pair(nBlockLastPaidOld, mnpair.first));
+            setMasternodesByLastPaid.emplace(mnpair.second.nBlockLastPaid, mnpair.first);
+            ListChanged();
+        }
     }
 
     nLastRunBlockHeight = nCachedBlockHeight;
@@ -1534,11 +1766,10 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
 void CMasternodeMan::CheckMasternode(const CPubKey& pubKeyMasternode, bool fForce)
 {
     LOCK2(cs_main, cs);
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnpair.second.Check(fForce);
-            return;
-        }
+    CMasternode* pmn = FindByPubKey(pubKeyMasternode);
+    if (pmn) {
+        pmn->Check(fForce);
+        ListChanged();
     }
 }
 
@@ -1557,6 +1788,7 @@ void CMasternodeMan::SetMasternodeLastPing(const COutPoint& outpoint, const CMas
         return;
     }
     pmn->lastPing = mnp;
+    ListChanged();
     mapSeenMasternodePing.insert(std::make_pair(mnp.GetHash(), mnp));
 
     CMasternodeBroadcast mnb(*pmn);
@@ -7,12 +7,46 @@
 
 #include <masternode.h>
 #include <sync.h>
+#include <unordered_lru_cache.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <set>
+#include <unordered_map>
 
 class CMasternodeMan;
 class CConnman;
 
 extern CMasternodeMan mnodeman;
 
+/** -mncachedumpinterval default, seconds between writing the masternode caches to disk */
+static const int64_t DEFAULT_MN_CACHE_DUMP_INTERVAL = 15 * 60;
+
+class SaltedKeyIDHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedKeyIDHasher();
+
+    size_t operator()(const CKeyID& id) const;
+};
+
+class SaltedServiceHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedServiceHasher();
+
+    size_t operator()(const CService& addr) const;
+};
+
 class CMasternodeMan
 {
 public:
@@ -20,6 +54,7 @@ public:
     typedef std::vector<score_pair_t> score_pair_vec_t;
     typedef std::pair<int, const CMasternode> rank_pair_t;
     typedef std::vector<rank_pair_t> rank_pair_vec_t;
+    typedef std::vector<CMasternode> list_snapshot_t;
 
 private:
     static const std::string SERIALIZATION_VERSION_STRING;
@@ -39,6 +74,13 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    // number of (block hash, min protocol) score vectors to remember
+    static const int SCORES_CACHE_SIZE              = 64;
+
+    struct ScoresCacheKeyHasher
+    {
+        size_t operator()(const std::pair<uint256, int>& key) const { return key.first.GetCheapHash() ^ key.second; }
+    };
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -48,6 +90,17 @@ private:
 
     // map to hold all MNs
     std::map<COutPoint, CMasternode> mapMasternodes;
+    // secondary indexes into mapMasternodes, by pubKeyMasternode id, by collateral key id (payee) and by address
+    std::unordered_multimap<CKeyID, COutPoint, SaltedKeyIDHasher> mapMasternodesByPubKey;
+    std::unordered_multimap<CKeyID, COutPoint, SaltedKeyIDHasher> mapMasternodesByPayee;
+    std::unordered_multimap<CService, COutPoint, SaltedServiceHasher> mapMasternodesByAddr;
+    // payment queue, (nBlockLastPaid, outpoint) of every masternode in payment order, least recently paid first
+    std::set<std::pair<int, COutPoint> > setMasternodesByLastPaid;
+    // sorted scores per (block hash, min protocol), must be cleared whenever the list or a protocol version changes
+    unordered_lru_cache<std::pair<uint256, int>, score_pair_vec_t, ScoresCacheKeyHasher> mapMasternodeScoresCache;
+    // immutable copy of mapMasternodes handed out to readers, rebuilt on the first read after the list changed
+    std::shared_ptr<const list_snapshot_t> pListSnapshot;
+    std::atomic<bool> fListSnapshotStale;
     // who's asked for the Masternode list and the last time
     std::map<CService, int64_t> mAskedUsForMasternodeList;
     // who we asked for the Masternode list and the last time
@@ -69,6 +122,16 @@ private:
     friend class CMasternodeSync;
     /// Find an entry
     CMasternode* Find(const COutPoint& outpoint);
+    /// Find the entry with the lowest outpoint using a given key of a secondary index
+    CMasternode* FindByPubKey(const CPubKey& pubKeyMasternode);
+    CMasternode* FindByPayee(const CScript& payee);
+
+    /// Keep the secondary indexes in sync with mapMasternodes
+    void IndexMasternode(const CMasternode& mn);
+    void UnindexMasternode(const CMasternode& mn);
+    void RebuildIndexes();
+    /// Call under cs after changing any masternode, the next reader gets a new snapshot
+    void ListChanged();
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
 
@@ -77,6 +140,10 @@ private:
 
     void PushDsegInvs(CNode* pnode, const CMasternode& mn);
 
+    /// Continue handling MNANNOUNCE and MNPING once CMessageVerifier recovered their signers
+    void ProcessBroadcast(CNode* pfrom, const CMasternodeBroadcast& mnb, CConnman& connman);
+    void ProcessPing(CNode* pfrom, CMasternodePing& mnp, CConnman& connman);
+
 public:
     // Keep track of all broadcasts I've seen
     std::map<uint256, std::pair<int64_t, CMasternodeBroadcast> > mapSeenMasternodeBroadcast;
@@ -115,6 +182,9 @@ public:
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
+        if(ser_action.ForRead()) {
+            RebuildIndexes();
+        }
     }
 
     CMasternodeMan();
@@ -161,15 +231,20 @@ public:
     bool GetMasternodeInfo(const CPubKey& pubKeyMasternode, masternode_info_t& mnInfoRet);
     bool GetMasternodeInfo(const CScript& payee, masternode_info_t& mnInfoRet);
 
-    /// Find an entry in the masternode list that is next to be paid
-    bool GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet);
+    /// Find an entry in the masternode list that is next to be paid.
+    /// Unless fCountAll is set, nCountRet stops growing once more qualifying masternodes can't change the result.
+    bool GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet, bool fCountAll = false);
     /// Same as above but use current block height
-    bool GetNextMasternodeInQueueForPayment(bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet);
+    bool GetNextMasternodeInQueueForPayment(bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet, bool fCountAll = false);
 
     /// Find a random entry
     masternode_info_t FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion = -1);
 
-    std::map<COutPoint, CMasternode> GetFullMasternodeMap() { return mapMasternodes; }
+    /// Get the masternode list in outpoint order, it can be kept and read without holding any lock
+    std::shared_ptr<const list_snapshot_t> GetListSnapshot();
+
+    /// Call func for every masternode in outpoint order, on a snapshot of the list and without holding any lock
+    void ForEachMasternode(const std::function<void(const CMasternode&)>& func);
 
     bool GetMasternodeRanks(rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight = -1, int nMinProtocol = 0);
     bool GetMasternodeRank(const COutPoint &outpoint, int& nRankRet, int nBlockHeight = -1, int nMinProtocol = 0);
@@ -0,0 +1,98 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <messagedispatcher.h>
+
+#include <net.h>
+#include <util.h>
+
+CMessageDispatcher messageDispatcher;
+
+CMessageDispatcher::CMessageDispatcher() : fInterrupt(true)
+{
+}
+
+void CMessageDispatcher::Start(int nThreads)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!vWorkers.empty() || nThreads <= 0) return;
+    fInterrupt = false;
+    for (int i = 0; i < nThreads; i++) {
+        vWorkers.emplace_back(new CWorker());
+        CWorker* pworker = vWorkers.back().get();
+        pworker->strName = strprintf("mnmsg.%d", i);
+        pworker->thread = std::thread(&TraceThread<std::function<void()> >, pworker->strName.c_str(), std::function<void()>(std::bind(&CMessageDispatcher::ThreadDispatch, this, pworker)));
+    }
+}
+
+void CMessageDispatcher::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        fInterrupt = true;
+        for (auto& pworker : vWorkers) {
+            pworker->condTasks.notify_all();
+        }
+    }
+    for (auto& pworker : vWorkers) {
+        if (pworker->thread.joinable()) pworker->thread.join();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto& pworker : vWorkers) {
+        for (CTask& task : pworker->queue) {
+            task.pfrom->RemovePendingMessage();
+            task.pfrom->Release();
+        }
+    }
+    vWorkers.clear();
+}
+
+void CMessageDispatcher::Push(CNode* pfrom, Task task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!fInterrupt) {
+            CWorker& worker = *vWorkers[pfrom->GetId() % vWorkers.size()];
+            if (worker.queue.size() >= MAX_MESSAGE_DISPATCH_QUEUE) {
+                // don't hold up the message handler, the message is dropped like one that never arrived
+                LogPrint(BCLog::MASTERNODE, "CMessageDispatcher::%s -- queue full, dropping message from peer=%d\n", __func__, pfrom->GetId());
+                return;
+            }
+            pfrom->AddPendingMessage();
+            worker.queue.push_back(CTask{pfrom->AddRef(), std::move(task)});
+            worker.condTasks.notify_one();
+            return;
+        }
+    }
+
+    // no dispatcher threads, do it right here
+    task(pfrom);
+}
+
+void CMessageDispatcher::ThreadDispatch(CWorker* pworker)
+{
+    while (true) {
+        CTask task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!fInterrupt && pworker->queue.empty()) {
+                pworker->condTasks.wait(lock);
+            }
+            if (fInterrupt) return;
+            task = std::move(pworker->queue.front());
+            pworker->queue.pop_front();
+        }
+
+        if (!task.pfrom->fDisconnect) {
+            try {
+                task.task(task.pfrom);
+            } catch (const std::exception& e) {
+                PrintExceptionContinue(&e, "CMessageDispatcher::ThreadDispatch()");
+            }
+        }
+        task.pfrom->RemovePendingMessage();
+        task.pfrom->Release();
+    }
+}
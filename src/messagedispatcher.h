@@ -0,0 +1,77 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MESSAGEDISPATCHER_H
+#define MESSAGEDISPATCHER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CMessageDispatcher;
+class CNode;
+
+extern CMessageDispatcher messageDispatcher;
+
+/** -mnmsgthreads default, threads handling masternode, InstantSend and PrivateSend messages */
+static const int DEFAULT_MN_MESSAGE_THREADS = 2;
+/** Most threads -mnmsgthreads can ask for */
+static const int MAX_MN_MESSAGE_THREADS = 16;
+/** Most messages waiting on one thread before CMessageDispatcher::Push drops new ones */
+static const size_t MAX_MESSAGE_DISPATCH_QUEUE = 5000;
+
+/**
+ * Handles the masternode, InstantSend and PrivateSend messages on a pool of
+ * threads of their own, so that block and transaction relay on the message
+ * handler thread doesn't wait behind them. All messages of a peer go to the
+ * same thread and are handled in the order they were pushed; messages of
+ * peers that disconnect in the meantime are dropped like the rest of their
+ * receive queue. Queued messages count as pending on their peer (see
+ * CNode::AddPendingMessage) so that the message handler keeps the order of
+ * the peer's other messages and stops handing over more from a busy peer.
+ */
+class CMessageDispatcher
+{
+public:
+    typedef std::function<void(CNode* pfrom)> Task;
+
+private:
+    struct CTask
+    {
+        CNode* pfrom;
+        Task task;
+    };
+
+    struct CWorker
+    {
+        std::deque<CTask> queue;
+        std::condition_variable condTasks;
+        std::string strName;
+        std::thread thread;
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<CWorker> > vWorkers;
+    bool fInterrupt;
+
+    void ThreadDispatch(CWorker* pworker);
+
+public:
+    CMessageDispatcher();
+
+    /// Start nThreads threads, tasks are run right away by Push until then or if nThreads is 0
+    void Start(int nThreads);
+    /// Finish the tasks in progress and drop the remaining ones, call before the peers go away
+    void Stop();
+
+    /// Run task with pfrom on the thread of pfrom, after everything pushed for pfrom before, or drop it if that thread is too far behind
+    void Push(CNode* pfrom, Task task);
+};
+
+#endif
@@ -6,9 +6,49 @@
 #include <hash.h>
 #include <validation.h> // For strMessageMagic
 #include <messagesigner.h>
+#include <saltedcuckoocache.h>
 #include <tinyformat.h>
+#include <util.h>
 #include <utilstrencodings.h>
 
+namespace {
+/**
+ * Cache of masternode message signatures that were found valid. Pings, payment
+ * votes and lock votes reach us from every peer that relays them, and each
+ * copy would otherwise have its public key recovered again.
+ */
+static CSaltedCuckooCache messageSigCache;
+
+//! Entries are SHA256(nonce || message hash || key ID || signature)
+uint256 MessageSigCacheEntry(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig)
+{
+    uint256 entry;
+    messageSigCache.GetHasher().Write(hash.begin(), 32).Write(keyID.begin(), keyID.size()).Write(vchSig.data(), vchSig.size()).Finalize(entry.begin());
+    return entry;
+}
+} // namespace
+
+void InitMessageSigCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-mnsigcachesize", DEFAULT_MN_SIG_CACHE_SIZE)), MAX_MN_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = messageSigCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for masternode message signature cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+uint256 CRecoveredSigner::GetSignedHash(const uint256& hashMessage, const std::vector<unsigned char>& vchSig)
+{
+    return Hash(hashMessage.begin(), hashMessage.end(), vchSig.begin(), vchSig.end());
+}
+
+uint256 CMessageSigner::GetMessageHash(const std::string& strMessage)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << strMessageMagic;
+    ss << strMessage;
+    return ss.GetHash();
+}
+
 bool CMessageSigner::GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {
     CKey key = DecodeSecret(strSecret);
@@ -23,36 +63,70 @@ bool CMessageSigner::GetKeysFromSecret(const std::string& strSecret, CKey& keyRe
 
 bool CMessageSigner::SignMessage(const std::string& strMessage, std::vector<unsigned char>& vchSigRet, const CKey& key)
 {
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << strMessageMagic;
-    ss << strMessage;
-
-    return key.SignCompact(ss.GetHash(), vchSigRet);
+    return key.SignCompact(GetMessageHash(strMessage), vchSigRet);
 }
 
-bool CMessageSigner::VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet)
+bool CMessageSigner::VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigner* precovered)
 {
-    return VerifyMessage(pubkey.GetID(), vchSig, strMessage, strErrorRet);
+    return VerifyMessage(pubkey.GetID(), vchSig, strMessage, strErrorRet, precovered);
 }
 
-bool CMessageSigner::VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet)
+bool CMessageSigner::VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigner* precovered)
 {
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << strMessageMagic;
-    ss << strMessage;
+    uint256 hash = GetMessageHash(strMessage);
 
-    CPubKey pubkeyFromSig;
-    if(!pubkeyFromSig.RecoverCompact(ss.GetHash(), vchSig)) {
-        strErrorRet = "Error recovering public key.";
-        return false;
+    CKeyID keyIDFromSig;
+    if(precovered && precovered->Matches(hash, vchSig)) {
+        keyIDFromSig = precovered->keyID;
+    } else {
+        CPubKey pubkeyFromSig;
+        if(!pubkeyFromSig.RecoverCompact(hash, vchSig)) {
+            strErrorRet = "Error recovering public key.";
+            return false;
+        }
+        keyIDFromSig = pubkeyFromSig.GetID();
     }
 
-    if(pubkeyFromSig.GetID() != keyID) {
+    if(keyIDFromSig != keyID) {
         strErrorRet = strprintf("Keys don't match: pubkey=%s, pubkeyFromSig=%s, hash=%s, vchSig=%s",
-                    keyID.ToString(), pubkeyFromSig.GetID().ToString(), ss.GetHash().ToString(),
+                    keyID.ToString(), keyIDFromSig.ToString(), hash.ToString(),
                     EncodeBase64(&vchSig[0], vchSig.size()));
         return false;
     }
 
     return true;
 }
+
+bool CMessageSigner::RecoverSigner(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyIDExpected, CRecoveredSigner& recoveredRet)
+{
+    uint256 entry;
+    if (!keyIDExpected.IsNull()) {
+        entry = MessageSigCacheEntry(hash, keyIDExpected, vchSig);
+        if (messageSigCache.Contains(entry)) {
+            recoveredRet.hashSigned = CRecoveredSigner::GetSignedHash(hash, vchSig);
+            recoveredRet.keyID = keyIDExpected;
+            return true;
+        }
+    }
+
+    CPubKey pubkeyFromSig;
+    if (!pubkeyFromSig.RecoverCompact(hash, vchSig))
+        return false;
+    recoveredRet.hashSigned = CRecoveredSigner::GetSignedHash(hash, vchSig);
+    recoveredRet.keyID = pubkeyFromSig.GetID();
+
+    if (!keyIDExpected.IsNull() && recoveredRet.keyID == keyIDExpected)
+        messageSigCache.Insert(entry);
+    return true;
+}
+
+bool CMessageSigner::VerifyMessageCached(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigner* precovered)
+{
+    uint256 entry = MessageSigCacheEntry(GetMessageHash(strMessage), pubkey.GetID(), vchSig);
+    if (messageSigCache.Contains(entry))
+        return true;
+    if (!VerifyMessage(pubkey, vchSig, strMessage, strErrorRet, precovered))
+        return false;
+    messageSigCache.Insert(entry);
+    return true;
+}
@@ -7,19 +7,55 @@
 
 #include <key.h>
 
+/** -mnsigcachesize default (MiB of verified masternode message signatures to remember) */
+static const int64_t DEFAULT_MN_SIG_CACHE_SIZE = 4;
+/** Maximum -mnsigcachesize allowed */
+static const int64_t MAX_MN_SIG_CACHE_SIZE = 1024;
+
+/** Key ID recovered from a message signature ahead of the check that needs it, see CMessageVerifier
+ */
+class CRecoveredSigner
+{
+public:
+    /// Hash of the signed message hash and signature the key was recovered from, null if none was
+    uint256 hashSigned;
+    CKeyID keyID;
+
+    static uint256 GetSignedHash(const uint256& hashMessage, const std::vector<unsigned char>& vchSig);
+
+    /// Return true if keyID was recovered from this signature of this message hash
+    bool Matches(const uint256& hashMessage, const std::vector<unsigned char>& vchSig) const
+    {
+        return !hashSigned.IsNull() && hashSigned == GetSignedHash(hashMessage, vchSig);
+    }
+};
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
 {
 public:
+    /// Hash of the message that actually gets signed
+    static uint256 GetMessageHash(const std::string& strMessage);
     /// Set the private/public key values, returns true if successful
     static bool GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet);
     /// Sign the message, returns true if successful
     static bool SignMessage(const std::string& strMessage, std::vector<unsigned char>& vchSigRet, const CKey& key);
+    /// Verify the message signature, returns true if succcessful.
+    /// The signer is taken from precovered instead of recovering it again if it matches.
+    static bool VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigner* precovered = nullptr);
     /// Verify the message signature, returns true if succcessful
-    static bool VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
-    /// Verify the message signature, returns true if succcessful
-    static bool VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
+    static bool VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigner* precovered = nullptr);
+    /// Recover the signer of a message hash into recoveredRet, returns true if successful.
+    /// A signature cached as valid for keyIDExpected is not recovered again, and one
+    /// that turns out to be valid for it is added to the cache.
+    static bool RecoverSigner(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyIDExpected, CRecoveredSigner& recoveredRet);
+    /// Same as VerifyMessage, but remember valid signatures so that the copies
+    /// of a message relayed by other peers don't get verified again
+    static bool VerifyMessageCached(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigner* precovered = nullptr);
 };
 
+/** Size the cache used by CMessageSigner::VerifyMessageCached according to -mnsigcachesize */
+void InitMessageSigCache();
+
 #endif
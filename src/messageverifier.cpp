@@ -0,0 +1,138 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <messageverifier.h>
+
+#include <net.h>
+#include <util.h>
+
+/** Most jobs recovered together before their continuations run */
+static const size_t MESSAGE_VERIFY_BATCH_SIZE = 256;
+
+CMessageVerifier messageVerifier;
+
+CMessageSigCheck::CMessageSigCheck(const std::string& strMessage, const std::vector<unsigned char>& vchSigIn, CRecoveredSigner& recoveredRet, const CKeyID& keyIDExpectedIn) :
+    hash(CMessageSigner::GetMessageHash(strMessage)),
+    vchSig(vchSigIn),
+    keyIDExpected(keyIDExpectedIn),
+    precovered(&recoveredRet)
+{
+}
+
+bool CMessageSigCheck::operator()()
+{
+    CMessageSigner::RecoverSigner(hash, vchSig, keyIDExpected, *precovered);
+    return true;
+}
+
+void CMessageSigCheck::swap(CMessageSigCheck& check)
+{
+    std::swap(hash, check.hash);
+    vchSig.swap(check.vchSig);
+    std::swap(keyIDExpected, check.keyIDExpected);
+    std::swap(precovered, check.precovered);
+}
+
+CMessageVerifier::CMessageVerifier() : fInterrupt(true), checkqueue(16)
+{
+}
+
+void CMessageVerifier::Start()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (threadVerify.joinable()) return;
+    fInterrupt = false;
+    threadVerify = std::thread(&TraceThread<std::function<void()> >, "msgverify", std::function<void()>(std::bind(&CMessageVerifier::ThreadVerify, this)));
+}
+
+void CMessageVerifier::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        fInterrupt = true;
+    }
+    condJobs.notify_all();
+    if (threadVerify.joinable()) threadVerify.join();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (CJob& job : queue) {
+        job.pfrom->RemovePendingMessage();
+        job.pfrom->Release();
+    }
+    queue.clear();
+}
+
+void CMessageVerifier::ThreadCheck()
+{
+    RenameThread("bitcoin-msgch");
+    checkqueue.Thread();
+}
+
+void CMessageVerifier::Push(CNode* pfrom, std::vector<CMessageSigCheck>& vChecks, Continuation continuation)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!fInterrupt) {
+            if (queue.size() >= MAX_MESSAGE_VERIFY_QUEUE) {
+                // don't hold up the caller, the message is dropped like one that never arrived
+                LogPrint(BCLog::MASTERNODE, "CMessageVerifier::%s -- queue full, dropping message from peer=%d\n", __func__, pfrom->GetId());
+                return;
+            }
+            pfrom->AddPendingMessage();
+            queue.push_back(CJob{pfrom->AddRef(), std::move(vChecks), std::move(continuation)});
+            condJobs.notify_one();
+            return;
+        }
+    }
+
+    // no verifier thread, do it all right here
+    for (CMessageSigCheck& check : vChecks) {
+        check();
+    }
+    continuation(pfrom);
+}
+
+void CMessageVerifier::ThreadVerify()
+{
+    while (true) {
+        std::vector<CJob> vJobs;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!fInterrupt && queue.empty()) {
+                condJobs.wait(lock);
+            }
+            if (fInterrupt) return;
+            while (!queue.empty() && vJobs.size() < MESSAGE_VERIFY_BATCH_SIZE) {
+                vJobs.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+
+        std::vector<CMessageSigCheck> vChecks;
+        for (CJob& job : vJobs) {
+            for (CMessageSigCheck& check : job.vChecks) {
+                vChecks.emplace_back();
+                vChecks.back().swap(check);
+            }
+        }
+        {
+            // the checks point into the messages owned by the continuations, which stay put
+            CCheckQueueControl<CMessageSigCheck> control(&checkqueue);
+            control.Add(vChecks);
+            control.Wait();
+        }
+
+        for (CJob& job : vJobs) {
+            if (!job.pfrom->fDisconnect) {
+                try {
+                    job.continuation(job.pfrom);
+                } catch (const std::exception& e) {
+                    PrintExceptionContinue(&e, "CMessageVerifier::ThreadVerify()");
+                }
+            }
+            job.pfrom->RemovePendingMessage();
+            job.pfrom->Release();
+        }
+    }
+}
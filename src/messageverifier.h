@@ -0,0 +1,97 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MESSAGEVERIFIER_H
+#define MESSAGEVERIFIER_H
+
+#include <checkqueue.h>
+#include <messagesigner.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class CMessageVerifier;
+class CNode;
+
+extern CMessageVerifier messageVerifier;
+
+/** Most jobs waiting for their signatures to be recovered before CMessageVerifier::Push drops new ones */
+static const size_t MAX_MESSAGE_VERIFY_QUEUE = 10000;
+
+/** Recovers the signer of one message signature into a CRecoveredSigner,
+ *  skipping the recovery if the signature is cached as valid for the key
+ *  the message is expected to be signed with
+ */
+class CMessageSigCheck
+{
+private:
+    uint256 hash;
+    std::vector<unsigned char> vchSig;
+    CKeyID keyIDExpected;
+    CRecoveredSigner* precovered;
+
+public:
+    CMessageSigCheck() : precovered(nullptr) {}
+    /// keyIDExpectedIn is the signer the message should have, or null if it isn't known
+    CMessageSigCheck(const std::string& strMessage, const std::vector<unsigned char>& vchSigIn, CRecoveredSigner& recoveredRet, const CKeyID& keyIDExpectedIn = CKeyID());
+
+    /// Always succeeds, a signature that can't be recovered just leaves its CRecoveredSigner unset
+    bool operator()();
+
+    void swap(CMessageSigCheck& check);
+};
+
+/**
+ * Recovers masternode message signatures in batches on a pool of worker
+ * threads, so that the message handler thread doesn't have to. Once the
+ * signatures of a job are recovered its continuation runs on the verifier
+ * thread, which takes whatever locks it needs; CheckSignature then finds the
+ * signer in the message's CRecoveredSigner. Jobs continue in the order they
+ * were pushed, so the messages of a peer are still handled in the order
+ * they arrived, and jobs of peers that disconnect in the meantime are dropped
+ * like the rest of their receive queue. Like dispatched messages, queued jobs
+ * count as pending on their peer.
+ */
+class CMessageVerifier
+{
+public:
+    typedef std::function<void(CNode* pfrom)> Continuation;
+
+private:
+    struct CJob
+    {
+        CNode* pfrom;
+        std::vector<CMessageSigCheck> vChecks;
+        Continuation continuation;
+    };
+
+    std::mutex mutex;
+    std::condition_variable condJobs;
+    std::deque<CJob> queue;
+    bool fInterrupt;
+    std::thread threadVerify;
+
+    CCheckQueue<CMessageSigCheck> checkqueue;
+
+    void ThreadVerify();
+
+public:
+    CMessageVerifier();
+
+    /// Start the verifier thread, jobs are handled right away by Push until then
+    void Start();
+    /// Finish the batch in progress and drop the remaining jobs, call before the peers go away
+    void Stop();
+
+    /// Worker thread, see ThreadScriptCheck
+    void ThreadCheck();
+
+    /// Recover the signers of vChecks and then call continuation with pfrom, or drop both if the queue is full
+    void Push(CNode* pfrom, std::vector<CMessageSigCheck>& vChecks, Continuation continuation);
+};
+
+#endif
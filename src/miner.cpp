@@ -6,6 +6,7 @@
 #include <miner.h>
 
 #include <amount.h>
+#include <arith_uint256.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <coins.h>
@@ -28,7 +29,9 @@
 #include <validationinterface.h>
 
 #include <algorithm>
+#include <atomic>
 #include <queue>
+#include <thread>
 #include <utility>
 
 // Unconfirmed transactions in the memory pool often depend on other
@@ -460,3 +463,120 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
     pblock->vtx[0] = MakeTransactionRef(std::move(txCoinbase));
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 }
+
+CNonceSearchPool::CNonceSearchPool(int nThreads) : pjob(nullptr), nGeneration(0), nRunning(0), fStop(false)
+{
+    for (int i = 1; i < nThreads; i++) {
+        vWorkers.emplace_back(&CNonceSearchPool::Thread, this);
+    }
+}
+
+CNonceSearchPool::~CNonceSearchPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fStop = true;
+    }
+    cvWork.notify_all();
+    for (std::thread& worker : vWorkers) {
+        worker.join();
+    }
+}
+
+void CNonceSearchPool::Thread()
+{
+    RenameThread("bitcoin-nonce");
+    uint64_t nDone = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cvWork.wait(lock, [&]() { return fStop || nGeneration != nDone; });
+        if (fStop) return;
+        nDone = nGeneration;
+        const std::function<void()>& job = *pjob;
+        lock.unlock();
+        job();
+        lock.lock();
+        if (--nRunning == 0) cvDone.notify_one();
+    }
+}
+
+void CNonceSearchPool::Run(const std::function<void()>& search)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pjob = &search;
+        nRunning = vWorkers.size();
+        nGeneration++;
+    }
+    cvWork.notify_all();
+    search();
+    std::unique_lock<std::mutex> lock(mutex);
+    cvDone.wait(lock, [&]() { return nRunning == 0; });
+    pjob = nullptr;
+}
+
+bool SolveBlockHeader(CBlockHeader* pblock, uint32_t nNonceEnd, uint64_t& nMaxTries, int nThreads, const Consensus::Params& consensusParams)
+{
+    CNonceSearchPool pool(nThreads);
+    return SolveBlockHeader(pblock, nNonceEnd, nMaxTries, pool, consensusParams);
+}
+
+bool SolveBlockHeader(CBlockHeader* pblock, uint32_t nNonceEnd, uint64_t& nMaxTries, CNonceSearchPool& pool, const Consensus::Params& consensusParams)
+{
+    const unsigned int profile = GetPoWProfile(*pblock, consensusParams);
+    const uint64_t nStart = pblock->nNonce;
+    const uint64_t nEnd = std::min<uint64_t>(std::max<uint64_t>(nNonceEnd, nStart), nStart + std::min<uint64_t>(nMaxTries, UINT32_MAX));
+    const int nThreads = pool.GetThreadCount();
+
+    // Easy targets (regtest) are met within a few tries, so don't make every
+    // thread hash a full batch when one hash each is already likely enough.
+    uint64_t nBatch = MINER_HASH_BATCH;
+    arith_uint256 bnTarget;
+    bool fNegative, fOverflow;
+    bnTarget.SetCompact(pblock->nBits, &fNegative, &fOverflow);
+    if (!fNegative && !fOverflow && bnTarget != 0) {
+        const arith_uint256 bnExpected = (~bnTarget / (bnTarget + 1)) + 1;
+        if (bnExpected < arith_uint256(nBatch * nThreads)) {
+            nBatch = std::max<uint64_t>(bnExpected.GetLow64() / nThreads, 1);
+        }
+    }
+
+    // Threads claim consecutive batches and always finish a claimed batch, so
+    // every nonce below the lowest solution gets hashed and the result is the
+    // same one a single thread would find.
+    std::atomic<uint64_t> nNext{nStart};
+    std::atomic<uint64_t> nSolution{UINT64_MAX};
+    const CBlockHeader header = *pblock;
+    auto search = [&]() {
+        std::vector<CBlockHeader> vBatch(nBatch, header);
+        std::vector<const CBlockHeader*> vHeaders;
+        while (nSolution.load() == UINT64_MAX) {
+            const uint64_t nBegin = nNext.fetch_add(nBatch);
+            if (nBegin >= nEnd) break;
+            vHeaders.clear();
+            for (uint64_t i = 0; i < std::min(nBatch, nEnd - nBegin); i++) {
+                vBatch[i].nNonce = nBegin + i;
+                vHeaders.push_back(&vBatch[i]);
+            }
+            const std::vector<uint256> vHashes = GetPoWHashes(vHeaders, profile);
+            for (size_t i = 0; i < vHashes.size(); i++) {
+                if (CheckProofOfWork(vHashes[i], header.nBits, consensusParams)) {
+                    uint64_t nFound = nSolution.load();
+                    while (nBegin + i < nFound && !nSolution.compare_exchange_weak(nFound, nBegin + i));
+                    break;
+                }
+            }
+        }
+    };
+
+    pool.Run(search);
+
+    if (nSolution.load() == UINT64_MAX) {
+        nMaxTries -= nEnd - nStart;
+        pblock->nNonce = nEnd;
+        return false;
+    }
+    nMaxTries -= nSolution.load() - nStart;
+    pblock->nNonce = nSolution.load();
+    return true;
+}
@@ -11,7 +11,11 @@
 #include <validation.h>
 
 #include <stdint.h>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 
@@ -22,6 +26,12 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** -genthreads default (nonce search threads for the generate RPCs, 0 = one per core) */
+static const int DEFAULT_GENERATE_THREADS = 0;
+/** Maximum number of nonce search threads */
+static const int MAX_GENERATE_THREADS = 64;
+/** Number of nonces a search thread hashes at once */
+static const unsigned int MINER_HASH_BATCH = 8;
 
 struct CBlockTemplate
 {
@@ -197,4 +207,44 @@ private:
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
 
+/**
+ * Threads searching nonces for SolveBlockHeader, started once and reused for
+ * every header so that each keeps its NeoScrypt scratchpad from block to
+ * block. The thread calling Run searches along, so a pool of one thread
+ * starts none. Run must not be called from several threads at once.
+ */
+class CNonceSearchPool
+{
+private:
+    std::mutex mutex;
+    std::condition_variable cvWork;
+    std::condition_variable cvDone;
+    const std::function<void()>* pjob;
+    uint64_t nGeneration;
+    size_t nRunning;
+    bool fStop;
+    std::vector<std::thread> vWorkers;
+
+    void Thread();
+
+public:
+    explicit CNonceSearchPool(int nThreads);
+    ~CNonceSearchPool();
+
+    int GetThreadCount() const { return vWorkers.size() + 1; }
+
+    /** Run search on every thread of the pool and return once all of them are done */
+    void Run(const std::function<void()>& search);
+};
+
+/**
+ * Search the nonces [pblock->nNonce, nNonceEnd) for the lowest one meeting
+ * pblock->nBits, spread over the threads of pool. On success pblock->nNonce
+ * is set to it; nMaxTries is reduced by the number of nonces tried before
+ * it, or by all of them if none was found.
+ */
+bool SolveBlockHeader(CBlockHeader* pblock, uint32_t nNonceEnd, uint64_t& nMaxTries, CNonceSearchPool& pool, const Consensus::Params& consensusParams);
+/** SolveBlockHeader over nThreads threads started just for this header */
+bool SolveBlockHeader(CBlockHeader* pblock, uint32_t nNonceEnd, uint64_t& nMaxTries, int nThreads, const Consensus::Params& consensusParams);
+
 #endif // BITCOIN_MINER_H
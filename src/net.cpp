@@ -2826,6 +2826,7 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     fSuccessfullyConnected = false;
     fDisconnect = false;
     nRefCount = 0;
+    nPendingMessages = 0;
     nSendSize = 0;
     nSendOffset = 0;
     hashContinue = uint256();
@@ -2874,6 +2875,7 @@ CNode::~CNode()
 
 void CNode::AskFor(const CInv& inv)
 {
+    LOCK(cs_askFor);
     if (mapAskFor.size() > MAPASKFOR_MAX_SZ || setAskFor.size() > SETASKFOR_MAX_SZ)
         return;
     // a peer may not have multiple non-responded queue positions for a single inv item
@@ -2906,6 +2908,14 @@ void CNode::AskFor(const CInv& inv)
     mapAskFor.insert(std::make_pair(nRequestTime, inv));
 }
 
+void CNode::RemovePendingMessage()
+{
+    assert(nPendingMessages > 0);
+    if (--nPendingMessages == 0 && g_connman) {
+        g_connman->WakeMessageHandler();
+    }
+}
+
 bool CConnman::NodeFullyConnected(const CNode* pnode)
 {
     return pnode && pnode->fSuccessfullyConnected && !pnode->fDisconnect;
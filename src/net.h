@@ -786,6 +786,9 @@ public:
     CCriticalSection cs_filter;
     std::unique_ptr<CBloomFilter> pfilter;
     std::atomic<int> nRefCount;
+    // Messages of this peer queued on or being handled by the dispatcher and verifier threads,
+    // the message handler holds back its other messages until they are done
+    std::atomic<int> nPendingMessages;
 
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
@@ -821,6 +824,8 @@ public:
     // List of non-tx/non-block inventory items
     std::vector<CInv> vInventoryOtherToSend;
     CCriticalSection cs_inventory;
+    // setAskFor and mapAskFor are also touched by the dispatcher threads, nothing is locked while holding cs_askFor
+    CCriticalSection cs_askFor;
     std::set<uint256> setAskFor;
     std::multimap<int64_t, CInv> mapAskFor;
     int64_t nNextInvSend;
@@ -974,6 +979,20 @@ public:
 
     void AskFor(const CInv& inv);
 
+    void RemoveAskFor(const uint256& hash)
+    {
+        LOCK(cs_askFor);
+        setAskFor.erase(hash);
+    }
+
+    void AddPendingMessage()
+    {
+        nPendingMessages++;
+    }
+
+    /** Called once a message counted by AddPendingMessage is done, wakes the message handler after the last one */
+    void RemovePendingMessage();
+
     void CloseSocketDisconnect();
 
     void copyStats(CNodeStats &stats);
@@ -234,3 +234,10 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 
     return true;
 }
+
+unsigned int GetPoWProfile(const CBlockHeader& block, const Consensus::Params& params)
+{
+    if (block.GetBlockTime() >= params.nNeoScryptFork)
+        return 0x0;
+    return 0x3;
+}
@@ -22,4 +22,7 @@ unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nF
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
 
+/** NeoScrypt profile used to hash a header: Scrypt before the NeoScrypt fork, NeoScrypt after it */
+unsigned int GetPoWProfile(const CBlockHeader& block, const Consensus::Params&);
+
 #endif // BITCOIN_POW_H
@@ -20,11 +20,26 @@ uint256 CBlockHeader::GetPoWHash(unsigned int profile) const
 {
     uint256 hash;
 
-    neoscrypt((unsigned char *) &nVersion, (unsigned char *) &hash, profile);
+    // Reuses this thread's scratchpad instead of allocating one per hash
+    if (neoscrypt_ctx_hash(neoscrypt_thread_ctx(), (unsigned char *) &nVersion, (unsigned char *) &hash, profile))
+        throw std::bad_alloc();
 
     return(hash);
 }
 
+std::vector<uint256> GetPoWHashes(const std::vector<const CBlockHeader*>& headers, unsigned int profile)
+{
+    std::vector<unsigned char> input(headers.size() * 80);
+    std::vector<uint256> hashes(headers.size());
+
+    for (size_t i = 0; i < headers.size(); i++)
+        memcpy(&input[i * 80], &headers[i]->nVersion, 80);
+
+    neoscrypt_N_way(input.data(), (unsigned char *) hashes.data(), profile, headers.size());
+
+    return hashes;
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
@@ -125,6 +125,10 @@ public:
     std::string ToString() const;
 };
 
+/** Compute GetPoWHash(profile) of several headers at once, hashing them in
+ * parallel lanes where the CPU supports it. */
+std::vector<uint256> GetPoWHashes(const std::vector<const CBlockHeader*>& headers, unsigned int profile);
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
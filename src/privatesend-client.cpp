@@ -12,6 +12,7 @@
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
+#include <messageverifier.h>
 #include <netmessagemaker.h>
 #include <script/sign.h>
 #include <shutdown.h>
@@ -33,9 +34,6 @@ void CPrivateSendClient::ProcessMessage(CNode* pfrom, const std::string& strComm
     if(!masternodeSync.IsBlockchainSynced()) return;
 
     if(strCommand == NetMsgType::DSQUEUE) {
-        TRY_LOCK(cs_darksend, lockRecv);
-        if(!lockRecv) return;
-
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
             connman.PushMessage(pfrom, CNetMsgMaker(pfrom->GetSendVersion()).Make(NetMsgType::REJECT, strCommand, REJECT_OBSOLETE,
@@ -43,70 +41,41 @@ void CPrivateSendClient::ProcessMessage(CNode* pfrom, const std::string& strComm
             return;
         }
 
-        CDarksendQueue dsq;
-        vRecv >> dsq;
+        auto pdsq = std::make_shared<CDarksendQueue>();
+        vRecv >> *pdsq;
+        const CDarksendQueue& dsq = *pdsq;
 
-        // process every dsq only once
-        for (const auto& q : vecDarksendQueue) {
-            if(q == dsq) {
-                // LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- %s seen\n", dsq.ToString());
-                return;
+        {
+            TRY_LOCK(cs_darksend, lockRecv);
+            if(!lockRecv) return;
+
+            // process every dsq only once
+            for (const auto& q : vecDarksendQueue) {
+                if(q == dsq) {
+                    // LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- %s seen\n", dsq.ToString());
+                    return;
+                }
             }
         }
 
         LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- %s new\n", dsq.ToString());
 
-        if(dsq.IsExpired()) return;
+        if(pdsq->IsExpired()) return;
 
+        // recover the signer off this thread, unless an unknown masternode makes the dsq invalid anyway
         masternode_info_t infoMn;
         if(!mnodeman.GetMasternodeInfo(dsq.masternodeOutpoint, infoMn)) return;
 
-        if(!dsq.CheckSignature(infoMn.pubKeyMasternode)) {
-            // we probably have outdated info
-            mnodeman.AskForMN(pfrom, dsq.masternodeOutpoint, connman);
-            return;
-        }
-
-        // if the queue is ready, submit if we can
-        if(dsq.fReady) {
-            if(!infoMixingMasternode.fInfoValid) return;
-            if(infoMixingMasternode.addr != infoMn.addr) {
-                LogPrintf("DSQUEUE -- message doesn't match current Masternode: infoMixingMasternode=%s, addr=%s\n", infoMixingMasternode.addr.ToString(), infoMn.addr.ToString());
-                return;
-            }
-
-            if(nState == POOL_STATE_QUEUE) {
-                LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- PrivateSend queue (%s) is ready on masternode %s\n", dsq.ToString(), infoMn.addr.ToString());
-                SubmitDenominate(connman);
-            }
-        } else {
-            for (const auto& q : vecDarksendQueue) {
-                if(q.masternodeOutpoint == dsq.masternodeOutpoint) {
-                    // no way same mn can send another "not yet ready" dsq this soon
-                    LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending WAY too many dsq messages\n", infoMn.addr.ToString());
-                    return;
-                }
-            }
+        std::vector<CMessageSigCheck> vChecks;
+        vChecks.emplace_back(dsq.GetSignatureMessage(), dsq.vchSig, pdsq->recoveredSigner, infoMn.pubKeyMasternode.GetID());
 
-            int nThreshold = infoMn.nLastDsq + mnodeman.CountEnabled(MIN_PRIVATESEND_PEER_PROTO_VERSION)/5;
-            LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- nLastDsq: %d  threshold: %d  nDsqCount: %d\n", infoMn.nLastDsq, nThreshold, mnodeman.nDsqCount);
-            //don't allow a few nodes to dominate the queuing process
-            if(infoMn.nLastDsq != 0 && nThreshold > mnodeman.nDsqCount) {
-                LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending too many dsq messages\n", infoMn.addr.ToString());
-                return;
-            }
-
-            if(!mnodeman.AllowMixing(dsq.masternodeOutpoint)) return;
-
-            LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- new PrivateSend queue (%s) from masternode %s\n", dsq.ToString(), infoMn.addr.ToString());
-            if(infoMixingMasternode.fInfoValid && infoMixingMasternode.outpoint == dsq.masternodeOutpoint) {
-                dsq.fTried = true;
-            }
-            vecDarksendQueue.push_back(dsq);
-            dsq.Relay(connman);
-        }
+        messageVerifier.Push(pfrom, vChecks, [this, pdsq, &connman](CNode* pfrom) {
+            ProcessQueue(pfrom, *pdsq, connman);
+        });
 
     } else if(strCommand == NetMsgType::DSSTATUSUPDATE) {
+        // the session is shared by all peers, whose messages are handled on several dispatcher threads
+        LOCK(cs_darksend);
 
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSSTATUSUPDATE -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
@@ -151,6 +120,7 @@ void CPrivateSendClient::ProcessMessage(CNode* pfrom, const std::string& strComm
         }
 
     } else if(strCommand == NetMsgType::DSFINALTX) {
+        LOCK(cs_darksend);
 
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSFINALTX -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
@@ -180,6 +150,7 @@ void CPrivateSendClient::ProcessMessage(CNode* pfrom, const std::string& strComm
         SignFinalTransaction(txNew, pfrom, connman);
 
     } else if(strCommand == NetMsgType::DSCOMPLETE) {
+        LOCK(cs_darksend);
 
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSCOMPLETE -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
@@ -214,6 +185,65 @@ void CPrivateSendClient::ProcessMessage(CNode* pfrom, const std::string& strComm
     }
 }
 
+void CPrivateSendClient::ProcessQueue(CNode* pfrom, CDarksendQueue& dsq, CConnman& connman)
+{
+    TRY_LOCK(cs_darksend, lockRecv);
+    if(!lockRecv) return;
+
+    // the same dsq may have come in from another peer meanwhile
+    for (const auto& q : vecDarksendQueue) {
+        if(q == dsq) return;
+    }
+
+    masternode_info_t infoMn;
+    if(!mnodeman.GetMasternodeInfo(dsq.masternodeOutpoint, infoMn)) return;
+
+    if(!dsq.CheckSignature(infoMn.pubKeyMasternode)) {
+        // we probably have outdated info
+        mnodeman.AskForMN(pfrom, dsq.masternodeOutpoint, connman);
+        return;
+    }
+
+    // if the queue is ready, submit if we can
+    if(dsq.fReady) {
+        if(!infoMixingMasternode.fInfoValid) return;
+        if(infoMixingMasternode.addr != infoMn.addr) {
+            LogPrintf("DSQUEUE -- message doesn't match current Masternode: infoMixingMasternode=%s, addr=%s\n", infoMixingMasternode.addr.ToString(), infoMn.addr.ToString());
+            return;
+        }
+
+        if(nState == POOL_STATE_QUEUE) {
+            LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- PrivateSend queue (%s) is ready on masternode %s\n", dsq.ToString(), infoMn.addr.ToString());
+            SubmitDenominate(connman);
+        }
+    } else {
+        for (const auto& q : vecDarksendQueue) {
+            if(q.masternodeOutpoint == dsq.masternodeOutpoint) {
+                // no way same mn can send another "not yet ready" dsq this soon
+                LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending WAY too many dsq messages\n", infoMn.addr.ToString());
+                return;
+            }
+        }
+
+        int nThreshold = infoMn.nLastDsq + mnodeman.CountEnabled(MIN_PRIVATESEND_PEER_PROTO_VERSION)/5;
+        LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- nLastDsq: %d  threshold: %d  nDsqCount: %d\n", infoMn.nLastDsq, nThreshold, mnodeman.nDsqCount);
+        //don't allow a few nodes to dominate the queuing process
+        if(infoMn.nLastDsq != 0 && nThreshold > mnodeman.nDsqCount) {
+            LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending too many dsq messages\n", infoMn.addr.ToString());
+            return;
+        }
+
+        if(!mnodeman.AllowMixing(dsq.masternodeOutpoint)) return;
+
+        LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- new PrivateSend queue (%s) from masternode %s\n", dsq.ToString(), infoMn.addr.ToString());
+        if(infoMixingMasternode.fInfoValid && infoMixingMasternode.outpoint == dsq.masternodeOutpoint) {
+            dsq.fTried = true;
+        }
+        vecDarksendQueue.push_back(dsq);
+        dsq.Relay(connman);
+    }
+}
+
 void CPrivateSendClient::ResetPool()
 {
     nCachedLastSuccessBlock = 0;
@@ -140,6 +140,9 @@ private:
 
     void RelayIn(const CDarkSendEntry& entry, CConnman& connman);
 
+    /// Continue handling a DSQUEUE once CMessageVerifier recovered its signer
+    void ProcessQueue(CNode* pfrom, CDarksendQueue& dsq, CConnman& connman);
+
     void SetNull();
 
 public:
@@ -11,6 +11,7 @@
 #include <instantx.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
+#include <messageverifier.h>
 #include <netmessagemaker.h>
 #include <script/interpreter.h>
 #include <shutdown.h>
@@ -27,6 +28,8 @@ void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strComm
     if(!masternodeSync.IsBlockchainSynced()) return;
 
     if(strCommand == NetMsgType::DSACCEPT) {
+        // the session is shared by all peers, whose messages are handled on several dispatcher threads
+        LOCK(cs_darksend);
 
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSACCEPT -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
@@ -77,9 +80,6 @@ void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strComm
         }
 
     } else if(strCommand == NetMsgType::DSQUEUE) {
-        TRY_LOCK(cs_darksend, lockRecv);
-        if(!lockRecv) return;
-
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
             connman.PushMessage(pfrom, CNetMsgMaker(pfrom->GetSendVersion()).Make(NetMsgType::REJECT, strCommand, REJECT_OBSOLETE,
@@ -87,54 +87,40 @@ void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strComm
             return;
         }
 
-        CDarksendQueue dsq;
-        vRecv >> dsq;
+        auto pdsq = std::make_shared<CDarksendQueue>();
+        vRecv >> *pdsq;
+        const CDarksendQueue& dsq = *pdsq;
 
-        // process every dsq only once
-        for (const auto& q : vecDarksendQueue) {
-            if(q == dsq) {
-                // LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- %s seen\n", dsq.ToString());
-                return;
+        {
+            TRY_LOCK(cs_darksend, lockRecv);
+            if(!lockRecv) return;
+
+            // process every dsq only once
+            for (const auto& q : vecDarksendQueue) {
+                if(q == dsq) {
+                    // LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- %s seen\n", dsq.ToString());
+                    return;
+                }
             }
         }
 
         LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- %s new\n", dsq.ToString());
 
-        if(dsq.IsExpired()) return;
+        if(pdsq->IsExpired()) return;
 
-        masternode_info_t mnInfo;
-        if(!mnodeman.GetMasternodeInfo(dsq.masternodeOutpoint, mnInfo)) return;
+        // recover the signer off this thread, unless an unknown masternode makes the dsq invalid anyway
+        masternode_info_t infoMn;
+        if(!mnodeman.GetMasternodeInfo(dsq.masternodeOutpoint, infoMn)) return;
 
-        if(!dsq.CheckSignature(mnInfo.pubKeyMasternode)) {
-            // we probably have outdated info
-            mnodeman.AskForMN(pfrom, dsq.masternodeOutpoint, connman);
-            return;
-        }
+        std::vector<CMessageSigCheck> vChecks;
+        vChecks.emplace_back(dsq.GetSignatureMessage(), dsq.vchSig, pdsq->recoveredSigner, infoMn.pubKeyMasternode.GetID());
 
-        if(!dsq.fReady) {
-            for (const auto& q : vecDarksendQueue) {
-                if(q.masternodeOutpoint == dsq.masternodeOutpoint) {
-                    // no way same mn can send another "not yet ready" dsq this soon
-                    LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending WAY too many dsq messages\n", mnInfo.addr.ToString());
-                    return;
-                }
-            }
-
-            int nThreshold = mnInfo.nLastDsq + mnodeman.CountEnabled(MIN_PRIVATESEND_PEER_PROTO_VERSION)/5;
-            LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- nLastDsq: %d  threshold: %d  nDsqCount: %d\n", mnInfo.nLastDsq, nThreshold, mnodeman.nDsqCount);
-            //don't allow a few nodes to dominate the queuing process
-            if(mnInfo.nLastDsq != 0 && nThreshold > mnodeman.nDsqCount) {
-                LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending too many dsq messages\n", mnInfo.addr.ToString());
-                return;
-            }
-            mnodeman.AllowMixing(dsq.masternodeOutpoint);
-
-            LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- new PrivateSend queue (%s) from masternode %s\n", dsq.ToString(), mnInfo.addr.ToString());
-            vecDarksendQueue.push_back(dsq);
-            dsq.Relay(connman);
-        }
+        messageVerifier.Push(pfrom, vChecks, [this, pdsq, &connman](CNode* pfrom) {
+            ProcessQueue(pfrom, *pdsq, connman);
+        });
 
     } else if(strCommand == NetMsgType::DSVIN) {
+        LOCK(cs_darksend);
 
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSVIN -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
@@ -235,6 +221,7 @@ void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strComm
         }
 
     } else if(strCommand == NetMsgType::DSSIGNFINALTX) {
+        LOCK(cs_darksend);
 
         if(pfrom->nVersion < MIN_PRIVATESEND_PEER_PROTO_VERSION) {
             LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
@@ -265,6 +252,49 @@ void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strComm
     }
 }
 
+void CPrivateSendServer::ProcessQueue(CNode* pfrom, CDarksendQueue& dsq, CConnman& connman)
+{
+    TRY_LOCK(cs_darksend, lockRecv);
+    if(!lockRecv) return;
+
+    // the same dsq may have come in from another peer meanwhile
+    for (const auto& q : vecDarksendQueue) {
+        if(q == dsq) return;
+    }
+
+    masternode_info_t mnInfo;
+    if(!mnodeman.GetMasternodeInfo(dsq.masternodeOutpoint, mnInfo)) return;
+
+    if(!dsq.CheckSignature(mnInfo.pubKeyMasternode)) {
+        // we probably have outdated info
+        mnodeman.AskForMN(pfrom, dsq.masternodeOutpoint, connman);
+        return;
+    }
+
+    if(!dsq.fReady) {
+        for (const auto& q : vecDarksendQueue) {
+            if(q.masternodeOutpoint == dsq.masternodeOutpoint) {
+                // no way same mn can send another "not yet ready" dsq this soon
+                LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending WAY too many dsq messages\n", mnInfo.addr.ToString());
+                return;
+            }
+        }
+
+        int nThreshold = mnInfo.nLastDsq + mnodeman.CountEnabled(MIN_PRIVATESEND_PEER_PROTO_VERSION)/5;
+        LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- nLastDsq: %d  threshold: %d  nDsqCount: %d\n", mnInfo.nLastDsq, nThreshold, mnodeman.nDsqCount);
+        //don't allow a few nodes to dominate the queuing process
+        if(mnInfo.nLastDsq != 0 && nThreshold > mnodeman.nDsqCount) {
+            LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- Masternode %s is sending too many dsq messages\n", mnInfo.addr.ToString());
+            return;
+        }
+        mnodeman.AllowMixing(dsq.masternodeOutpoint);
+
+        LogPrint(BCLog::PRIVATESEND, "DSQUEUE -- new PrivateSend queue (%s) from masternode %s\n", dsq.ToString(), mnInfo.addr.ToString());
+        vecDarksendQueue.push_back(dsq);
+        dsq.Relay(connman);
+    }
+}
+
 void CPrivateSendServer::SetNull()
 {
     // MN side
@@ -63,6 +63,9 @@ private:
     void RelayStatus(PoolStatusUpdate nStatusUpdate, CConnman& connman, PoolMessage nMessageID = MSG_NOERR);
     void RelayCompletedTransaction(PoolMessage nMessageID, CConnman& connman);
 
+    /// Continue handling a DSQUEUE once CMessageVerifier recovered its signer
+    void ProcessQueue(CNode* pfrom, CDarksendQueue& dsq, CConnman& connman);
+
     void SetNull();
 
 public:
@@ -43,16 +43,21 @@ uint256 CDarksendQueue::GetSignatureHash() const
     return SerializeHash(*this);
 }
 
+std::string CDarksendQueue::GetSignatureMessage() const
+{
+    return CTxIn(masternodeOutpoint).ToString() +
+                    boost::lexical_cast<std::string>(nDenom) +
+                    boost::lexical_cast<std::string>(nTime) +
+                    boost::lexical_cast<std::string>(fReady);
+}
+
 bool CDarksendQueue::Sign()
 {
     if(!fMasternodeMode) return false;
 
     std::string strError = "";
 
-    std::string strMessage = CTxIn(masternodeOutpoint).ToString() +
-                    boost::lexical_cast<std::string>(nDenom) +
-                    boost::lexical_cast<std::string>(nTime) +
-                    boost::lexical_cast<std::string>(fReady);
+    std::string strMessage = GetSignatureMessage();
 
     if(!CMessageSigner::SignMessage(strMessage, vchSig, activeMasternode.keyMasternode)) {
         LogPrintf("CDarksendQueue::Sign -- SignMessage() failed, %s\n", ToString());
@@ -71,12 +76,9 @@ bool CDarksendQueue::CheckSignature(const CPubKey& pubKeyMasternode) const
 {
     std::string strError = "";
 
-    std::string strMessage = CTxIn(masternodeOutpoint).ToString() +
-                    boost::lexical_cast<std::string>(nDenom) +
-                    boost::lexical_cast<std::string>(nTime) +
-                    boost::lexical_cast<std::string>(fReady);
+    std::string strMessage = GetSignatureMessage();
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError, &recoveredSigner)) {
         LogPrintf("CDarksendQueue::CheckSignature -- Got bad Masternode queue signature: %s; error: %s\n", ToString(), strError);
         return false;
     }
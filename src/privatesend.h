@@ -7,6 +7,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <messagesigner.h>
 #include <primitives/transaction.h>
 #include <pubkey.h>
 #include <sync.h>
@@ -175,6 +176,8 @@ public:
     std::vector<unsigned char> vchSig;
     // memory only
     bool fTried;
+    // not serialized, filled in by CMessageVerifier
+    CRecoveredSigner recoveredSigner;
 
     CDarksendQueue() :
         nDenom(0),
@@ -208,6 +211,7 @@ public:
     }
 
     uint256 GetSignatureHash() const;
+    std::string GetSignatureMessage() const;
     /** Sign this mixing transaction
      *  \return true if all conditions are met:
      *     1) we have an active Masternode,
@@ -289,12 +289,9 @@ void MasternodeList::updateNodeList()
     ui->tableWidgetMasternodes->setSortingEnabled(false);
     ui->tableWidgetMasternodes->clearContents();
     ui->tableWidgetMasternodes->setRowCount(0);
-    std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
     int offsetFromUtc = GetOffsetFromUtc();
 
-    for (const auto& mnpair : mapMasternodes)
-    {
-        CMasternode mn = mnpair.second;
+    mnodeman.ForEachMasternode([&](const CMasternode& mn) {
         // populate list
         // Address, Protocol, Status, Active Seconds, Last Seen, Pub Key
         QTableWidgetItem *addressItem = new QTableWidgetItem(QString::fromStdString(mn.addr.ToString()));
@@ -312,7 +309,7 @@ void MasternodeList::updateNodeList()
                             activeSecondsItem->text() + " " +
                             lastSeenItem->text() + " " +
                             pubkeyItem->text();
-            if (!strToFilter.contains(strCurrentFilter)) continue;
+            if (!strToFilter.contains(strCurrentFilter)) return;
         }
 
         ui->tableWidgetMasternodes->insertRow(0);
@@ -322,7 +319,7 @@ void MasternodeList::updateNodeList()
         ui->tableWidgetMasternodes->setItem(0, 3, activeSecondsItem);
         ui->tableWidgetMasternodes->setItem(0, 4, lastSeenItem);
         ui->tableWidgetMasternodes->setItem(0, 5, pubkeyItem);
-    }
+    });
 
     ui->countLabel->setText(QString::number(ui->tableWidgetMasternodes->rowCount()));
     ui->tableWidgetMasternodes->setSortingEnabled(true);
@@ -6,6 +6,7 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -393,6 +394,63 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     }
 }
 
+static bool rest_spent(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    uint256 txid;
+    int32_t nOutput;
+    const std::string::size_type pos = param.find('-');
+    if (pos == std::string::npos || !ParseHashStr(param.substr(0, pos), txid) ||
+        !ParseInt32(param.substr(pos + 1), &nOutput) || nOutput < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+
+    if (!g_spentindex)
+        return RESTERR(req, HTTP_NOT_FOUND, "Spent index not enabled, use -spentindex");
+    g_spentindex->BlockUntilSyncedToCurrentChain();
+
+    CSpentIndexEntry entry;
+    if (!g_spentindex->FindSpent(COutPoint(txid, (uint32_t)nOutput), entry))
+        return RESTERR(req, HTTP_NOT_FOUND, param + " not spent");
+
+    CDataStream ssSpent(SER_NETWORK, PROTOCOL_VERSION);
+    ssSpent << entry;
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        std::string binarySpent = ssSpent.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binarySpent);
+        return true;
+    }
+
+    case RetFormat::HEX: {
+        std::string strHex = HexStr(ssSpent.begin(), ssSpent.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RetFormat::JSON: {
+        UniValue objSpent(UniValue::VOBJ);
+        objSpent.pushKV("txid", entry.txid.GetHex());
+        objSpent.pushKV("index", (int64_t)entry.nInputIndex);
+        objSpent.pushKV("height", entry.nHeight);
+        std::string strJSON = objSpent.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
 {
     if (!CheckWarmup(req))
@@ -589,6 +647,7 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/spent/", rest_spent},
 };
 
 bool StartREST()
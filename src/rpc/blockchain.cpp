@@ -17,6 +17,9 @@
 #include <instantx.h>
 #include <validation.h>
 #include <core_io.h>
+#include <index/addressindex.h>
+#include <index/blockfilterindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <key_io.h>
 #include <policy/feerate.h>
@@ -833,6 +836,16 @@ static UniValue getblock(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
     }
 
+    // Without flags the serialization matches the block file, so encode the
+    // mapped bytes instead of deserializing and serializing the block again.
+    if (verbosity <= 0 && RPCSerializationFlags() == 0 && !IsBlockPruned(pblockindex)) {
+        Span<const uint8_t> block_span;
+        std::shared_ptr<const CMappedBlockFile> block_map;
+        if (ReadRawBlockFromDisk(block_span, block_map, pblockindex, Params().MessageStart())) {
+            return HexStr(block_span.begin(), block_span.end());
+        }
+    }
+
     const CBlock block = GetBlockChecked(pblockindex);
 
     if (verbosity <= 0)
@@ -1473,6 +1486,9 @@ UniValue mempoolInfoToJSON()
     ret.pushKV("maxmempool", (int64_t) maxmempool);
     ret.pushKV("mempoolminfee", ValueFromAmount(std::max(mempool.GetMinFee(maxmempool), ::minRelayTxFee).GetFeePerK()));
     ret.pushKV("minrelaytxfee", ValueFromAmount(::minRelayTxFee.GetFeePerK()));
+    ret.pushKV("instantsendorphanvotes", (int64_t) instantsend.GetOrphanVoteCount());
+    ret.pushKV("instantsendorphanusage", (int64_t) instantsend.DynamicOrphanVotesUsage());
+    ret.pushKV("maxinstantsendorphanusage", (int64_t) MAX_ORPHAN_TXLOCK_VOTES_USAGE);
 
     return ret;
 }
@@ -1490,7 +1506,10 @@ static UniValue getmempoolinfo(const JSONRPCRequest& request)
             "  \"usage\": xxxxx,              (numeric) Total memory usage for the mempool\n"
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
             "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee rate in " + CURRENCY_UNIT + "/kB for tx to be accepted. Is the maximum of minrelaytxfee and minimum mempool fee\n"
-            "  \"minrelaytxfee\": xxxxx       (numeric) Current minimum relay fee for transactions\n"
+            "  \"minrelaytxfee\": xxxxx,      (numeric) Current minimum relay fee for transactions\n"
+            "  \"instantsendorphanvotes\": xxxxx,    (numeric) InstantSend votes waiting for their lock request\n"
+            "  \"instantsendorphanusage\": xxxxx,    (numeric) Total memory usage for the InstantSend orphan votes\n"
+            "  \"maxinstantsendorphanusage\": xxxxx (numeric) Maximum memory usage for the InstantSend orphan votes\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -2244,6 +2263,284 @@ UniValue scantxoutset(const JSONRPCRequest& request)
     return result;
 }
 
+/** Most entries returned by one call of getaddresshistory or getaddressutxos */
+static const int MAX_ADDRESS_INDEX_PAGE = 1000;
+
+static CScript AddressIndexScript(const UniValue& address)
+{
+    if (!g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled, use -addressindex");
+    }
+    CTxDestination dest = DecodeDestination(address.get_str());
+    if (!IsValidDestination(dest)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+    g_addressindex->BlockUntilSyncedToCurrentChain();
+    return GetScriptForDestination(dest);
+}
+
+static void AddressIndexPage(const JSONRPCRequest& request, size_t& skip, size_t& count)
+{
+    int nSkip = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    int nCount = request.params[2].isNull() ? 100 : request.params[2].get_int();
+    if (nSkip < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative skip");
+    }
+    if (nCount < 0 || nCount > MAX_ADDRESS_INDEX_PAGE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("count must be between 0 and %d", MAX_ADDRESS_INDEX_PAGE));
+    }
+    skip = nSkip;
+    count = nCount;
+}
+
+static UniValue getaddresshistory(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddresshistory \"address\" ( skip count )\n"
+            "\nReturns the outputs received and spent by an address in the active chain, oldest first.\n"
+            "Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"        (string, required) The guncoin address\n"
+            "2. skip               (numeric, optional, default=0) Number of entries to skip\n"
+            "3. count              (numeric, optional, default=100) Most entries to return, up to " + std::to_string(MAX_ADDRESS_INDEX_PAGE) + "\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\" : \"hash\",     (string) The transaction id\n"
+            "    \"height\" : n,        (numeric) The height of the block containing the transaction\n"
+            "    \"index\" : n,         (numeric) The vout received, or the vin spending it\n"
+            "    \"spending\" : true|false, (boolean) Whether the entry spends an output\n"
+            "    \"amount\" : x.xxx,    (numeric) The amount in " + CURRENCY_UNIT + ", negative for spends\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddresshistory", "\"GnTP1LSPEQSipa8CBrFV5UDnPYvXTGaMM7\" 0 10")
+            + HelpExampleRpc("getaddresshistory", "\"GnTP1LSPEQSipa8CBrFV5UDnPYvXTGaMM7\", 0, 10")
+        );
+
+    const CScript script = AddressIndexScript(request.params[0]);
+    size_t skip, count;
+    AddressIndexPage(request, skip, count);
+
+    std::vector<CAddressHistoryEntry> entries;
+    if (!g_addressindex->FindHistory(script, skip, count, entries)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const CAddressHistoryEntry& entry : entries) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", entry.txid.GetHex());
+        obj.pushKV("height", entry.nHeight);
+        obj.pushKV("index", (int64_t)entry.nIndex);
+        obj.pushKV("spending", entry.fSpending);
+        obj.pushKV("amount", ValueFromAmount(entry.nValue));
+        result.push_back(obj);
+    }
+    return result;
+}
+
+static UniValue getaddressutxos(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddressutxos \"address\" ( skip count )\n"
+            "\nReturns the unspent outputs paid to an address in the active chain, oldest first.\n"
+            "Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"        (string, required) The guncoin address\n"
+            "2. skip               (numeric, optional, default=0) Number of entries to skip\n"
+            "3. count              (numeric, optional, default=100) Most entries to return, up to " + std::to_string(MAX_ADDRESS_INDEX_PAGE) + "\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\" : \"hash\",     (string) The transaction id\n"
+            "    \"vout\" : n,          (numeric) The vout value\n"
+            "    \"height\" : n,        (numeric) The height of the block containing the transaction\n"
+            "    \"amount\" : x.xxx,    (numeric) The amount in " + CURRENCY_UNIT + "\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressutxos", "\"GnTP1LSPEQSipa8CBrFV5UDnPYvXTGaMM7\"")
+            + HelpExampleRpc("getaddressutxos", "\"GnTP1LSPEQSipa8CBrFV5UDnPYvXTGaMM7\"")
+        );
+
+    const CScript script = AddressIndexScript(request.params[0]);
+    size_t skip, count;
+    AddressIndexPage(request, skip, count);
+
+    std::vector<CAddressUnspentEntry> entries;
+    if (!g_addressindex->FindUnspent(script, skip, count, entries)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const CAddressUnspentEntry& entry : entries) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", entry.outpoint.hash.GetHex());
+        obj.pushKV("vout", (int64_t)entry.outpoint.n);
+        obj.pushKV("height", entry.nHeight);
+        obj.pushKV("amount", ValueFromAmount(entry.nValue));
+        result.push_back(obj);
+    }
+    return result;
+}
+
+static UniValue getaddressbalance(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getaddressbalance \"address\"\n"
+            "\nReturns the balance of an address in the active chain.\n"
+            "Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"        (string, required) The guncoin address\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"balance\" : x.xxx,    (numeric) The total of the unspent outputs in " + CURRENCY_UNIT + "\n"
+            "  \"received\" : x.xxx,   (numeric) The total ever received in " + CURRENCY_UNIT + "\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressbalance", "\"GnTP1LSPEQSipa8CBrFV5UDnPYvXTGaMM7\"")
+            + HelpExampleRpc("getaddressbalance", "\"GnTP1LSPEQSipa8CBrFV5UDnPYvXTGaMM7\"")
+        );
+
+    const CScript script = AddressIndexScript(request.params[0]);
+
+    CAmount balance, received;
+    if (!g_addressindex->GetBalance(script, balance, received)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", ValueFromAmount(balance));
+    result.pushKV("received", ValueFromAmount(received));
+    return result;
+}
+
+static UniValue getspentinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 2)
+        throw std::runtime_error(
+            "getspentinfo \"txid\" n\n"
+            "\nReturns the input spending an output in the active chain.\n"
+            "Requires -spentindex.\n"
+            "\nArguments:\n"
+            "1. \"txid\"           (string, required) The transaction id\n"
+            "2. n                (numeric, required) The vout number\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"txid\" : \"hash\",     (string) The id of the spending transaction\n"
+            "  \"index\" : n,         (numeric) The vin spending the output\n"
+            "  \"height\" : n,        (numeric) The height of the block containing the spending transaction\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getspentinfo", "\"mytxid\" 0")
+            + HelpExampleRpc("getspentinfo", "\"mytxid\", 0")
+        );
+
+    if (!g_spentindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent index not enabled, use -spentindex");
+    }
+
+    uint256 hash = ParseHashV(request.params[0], "txid");
+    int n = request.params[1].get_int();
+    if (n < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, vout must be non-negative");
+    }
+
+    g_spentindex->BlockUntilSyncedToCurrentChain();
+
+    CSpentIndexEntry entry;
+    if (!g_spentindex->FindSpent(COutPoint(hash, n), entry)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Output not spent in the active chain");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("txid", entry.txid.GetHex());
+    result.pushKV("index", (int64_t)entry.nInputIndex);
+    result.pushKV("height", entry.nHeight);
+    return result;
+}
+
+static UniValue getblockfilter(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "getblockfilter \"blockhash\" ( \"filtertype\" )\n"
+            "\nRetrieve a BIP 157 content filter for a particular block.\n"
+            "Requires -blockfilterindex.\n"
+            "\nArguments:\n"
+            "1. \"blockhash\"      (string, required) The hash of the block\n"
+            "2. \"filtertype\"     (string, optional, default=basic) The type name of the filter\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filter\" : \"hex\",   (string) the hex-encoded filter data\n"
+            "  \"header\" : \"hash\",  (string) the hex-encoded filter header\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\" \"basic\"")
+            + HelpExampleRpc("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\", \"basic\"")
+        );
+
+    uint256 block_hash = ParseHashV(request.params[0], "blockhash");
+    std::string filtertype_name = "basic";
+    if (!request.params[1].isNull()) {
+        filtertype_name = request.params[1].get_str();
+    }
+
+    BlockFilterType filtertype;
+    if (!BlockFilterTypeByName(filtertype_name, filtertype)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
+    }
+
+    if (!g_blockfilterindex || g_blockfilterindex->GetFilterType() != filtertype) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is not enabled for filtertype " + filtertype_name);
+    }
+
+    const CBlockIndex* block_index;
+    bool block_was_connected;
+    {
+        LOCK(cs_main);
+        block_index = LookupBlockIndex(block_hash);
+        if (!block_index) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        block_was_connected = block_index->IsValid(BLOCK_VALID_SCRIPTS);
+    }
+
+    bool index_ready = g_blockfilterindex->BlockUntilSyncedToCurrentChain();
+
+    BlockFilter filter;
+    uint256 filter_header;
+    if (!g_blockfilterindex->LookupFilter(block_index, filter) ||
+        !g_blockfilterindex->LookupFilterHeader(block_index, filter_header)) {
+        int err_code;
+        std::string errmsg = "Filter not found.";
+
+        if (!block_was_connected) {
+            err_code = RPC_INVALID_ADDRESS_OR_KEY;
+            errmsg += " Block was not connected to active chain.";
+        } else if (!index_ready) {
+            err_code = RPC_MISC_ERROR;
+            errmsg += " Block filters are still in the process of being indexed.";
+        } else {
+            err_code = RPC_INTERNAL_ERROR;
+            errmsg += " This error is unexpected and indicates index corruption.";
+        }
+
+        throw JSONRPCError(err_code, errmsg);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("filter", HexStr(filter.GetEncodedFilter()));
+    ret.pushKV("header", filter_header.GetHex());
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
@@ -2272,6 +2569,11 @@ static const CRPCCommand commands[] =
 
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
     { "blockchain",         "scantxoutset",           &scantxoutset,           {"action", "scanobjects"} },
+    { "blockchain",         "getaddresshistory",      &getaddresshistory,      {"address", "skip", "count"} },
+    { "blockchain",         "getaddressutxos",        &getaddressutxos,        {"address", "skip", "count"} },
+    { "blockchain",         "getaddressbalance",      &getaddressbalance,      {"address"} },
+    { "blockchain",         "getspentinfo",           &getspentinfo,           {"txid", "n"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
 
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        {"blockhash"} },
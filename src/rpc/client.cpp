@@ -92,6 +92,11 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "sendmany", 9 , "use_is" },
     { "sendmany", 10 , "use_ps" },
     { "scantxoutset", 1, "scanobjects" },
+    { "getaddresshistory", 1, "skip" },
+    { "getaddresshistory", 2, "count" },
+    { "getaddressutxos", 1, "skip" },
+    { "getaddressutxos", 2, "count" },
+    { "getspentinfo", 1, "n" },
     { "addmultisigaddress", 0, "nrequired" },
     { "addmultisigaddress", 1, "keys" },
     { "createmultisig", 0, "nrequired" },
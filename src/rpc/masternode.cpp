@@ -203,7 +203,7 @@ UniValue masternode(const JSONRPCRequest& request)
 
         int nCount;
         masternode_info_t mnInfo;
-        mnodeman.GetNextMasternodeInQueueForPayment(true, nCount, mnInfo);
+        mnodeman.GetNextMasternodeInQueueForPayment(true, nCount, mnInfo, true);
 
         int total = mnodeman.size();
         int ps = mnodeman.CountEnabled(MIN_PRIVATESEND_PEER_PROTO_VERSION);
@@ -551,22 +551,20 @@ UniValue masternodelist(const JSONRPCRequest& request)
             obj.push_back(Pair(strOutpoint, rankpair.first));
         }
     } else {
-        std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
-        for (const auto& mnpair : mapMasternodes) {
-            CMasternode mn = mnpair.second;
-            std::string strOutpoint = mnpair.first.ToStringShort();
+        mnodeman.ForEachMasternode([&](const CMasternode& mn) {
+            std::string strOutpoint = mn.outpoint.ToStringShort();
             if (strMode == "activeseconds") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, (int64_t)(mn.lastPing.sigTime - mn.sigTime)));
             } else if (strMode == "addr") {
                 std::string strAddress = mn.addr.ToString();
                 if (strFilter !="" && strAddress.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, strAddress));
             } else if (strMode == "daemon") {
                 std::string strDaemon = mn.lastPing.nDaemonVersion > DEFAULT_DAEMON_VERSION ? FormatVersion(mn.lastPing.nDaemonVersion) : "Unknown";
                 if (strFilter !="" && strDaemon.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, strDaemon));
             } else if (strMode == "full") {
                 std::ostringstream streamFull;
@@ -581,7 +579,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                                mn.addr.ToString();
                 std::string strFull = streamFull.str();
                 if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, strFull));
             } else if (strMode == "info") {
                 std::ostringstream streamInfo;
@@ -594,7 +592,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                                mn.addr.ToString();
                 std::string strInfo = streamInfo.str();
                 if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, strInfo));
             } else if (strMode == "json") {
                 std::ostringstream streamInfo;
@@ -609,7 +607,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                                mn.GetLastPaidBlock();
                 std::string strInfo = streamInfo.str();
                 if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 UniValue objMN(UniValue::VOBJ);
                 objMN.push_back(Pair("address", mn.addr.ToString()));
                 objMN.push_back(Pair("payee", EncodeDestination(mn.pubKeyCollateralAddress.GetID())));
@@ -622,33 +620,33 @@ UniValue masternodelist(const JSONRPCRequest& request)
                 objMN.push_back(Pair("lastpaidblock", mn.GetLastPaidBlock()));
                 obj.push_back(Pair(strOutpoint, objMN));
             } else if (strMode == "lastpaidblock") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, mn.GetLastPaidBlock()));
             } else if (strMode == "lastpaidtime") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, mn.GetLastPaidTime()));
             } else if (strMode == "lastseen") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, (int64_t)mn.lastPing.sigTime));
             } else if (strMode == "payee") {
                 std::string strPayee = EncodeDestination(mn.pubKeyCollateralAddress.GetID());
                 if (strFilter !="" && strPayee.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, strPayee));
             } else if (strMode == "protocol") {
                 if (strFilter !="" && strFilter != strprintf("%d", mn.nProtocolVersion) &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, mn.nProtocolVersion));
             } else if (strMode == "pubkey") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, HexStr(mn.pubKeyMasternode)));
             } else if (strMode == "status") {
                 std::string strStatus = mn.GetStatus();
                 if (strFilter !="" && strStatus.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.push_back(Pair(strOutpoint, strStatus));
             }
-        }
+        });
     }
     return obj;
 }
@@ -0,0 +1,61 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SALTEDCUCKOOCACHE_H
+#define BITCOIN_SALTEDCUCKOOCACHE_H
+
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
+#include <random.h>
+#include <script/sigcache.h>
+#include <uint256.h>
+
+#include <boost/thread.hpp>
+
+/**
+ * Thread-safe set of things found valid before, such as proofs of work or
+ * signatures, so that they don't get checked again. Entries are
+ * SHA256(nonce || data) with a random nonce per cache, so peers can't aim
+ * for collisions: callers write their data into GetHasher() and look up or
+ * insert what it finalizes to.
+ */
+class CSaltedCuckooCache
+{
+private:
+    //! SHA256 already fed with the nonce
+    CSHA256 saltedHasher;
+    CuckooCache::cache<uint256, SignatureCacheHasher> setValid;
+    boost::shared_mutex cs_cache;
+
+public:
+    CSaltedCuckooCache()
+    {
+        uint256 nonce;
+        GetRandBytes(nonce.begin(), 32);
+        saltedHasher.Write(nonce.begin(), 32);
+    }
+
+    /// Hasher to write the data of an entry into before finalizing it
+    CSHA256 GetHasher() const { return saltedHasher; }
+
+    bool Contains(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_cache);
+        return setValid.contains(entry, false);
+    }
+
+    void Insert(uint256 entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_cache);
+        setValid.insert(entry);
+    }
+
+    /// Size the cache, zero gives the smallest one possible (2 elements)
+    uint32_t setup_bytes(size_t n)
+    {
+        return setValid.setup_bytes(n);
+    }
+};
+
+#endif // BITCOIN_SALTEDCUCKOOCACHE_H
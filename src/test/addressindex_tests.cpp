@@ -0,0 +1,101 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/addressindex.h>
+#include <script/standard.h>
+#include <test/test_bitcoin.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+static void WaitUntilSynced(AddressIndex& addressindex)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!addressindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_initial_sync, TestChain100Setup)
+{
+    AddressIndex addressindex(1 << 20, true);
+
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const CScript spend_script = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    std::vector<CAddressHistoryEntry> history;
+    std::vector<CAddressUnspentEntry> unspent;
+    CAmount balance, received;
+
+    BOOST_CHECK(addressindex.FindUnspent(coinbase_script, 0, 1000, unspent));
+    BOOST_CHECK(unspent.empty());
+
+    addressindex.Start();
+    WaitUntilSynced(addressindex);
+
+    // All coinbase outputs that were in the chain before it started are unspent, in chain order.
+    BOOST_CHECK(addressindex.FindUnspent(coinbase_script, 0, 1000, unspent));
+    BOOST_REQUIRE_EQUAL(unspent.size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < unspent.size(); i++) {
+        BOOST_CHECK(unspent[i].outpoint == COutPoint(m_coinbase_txns[i]->GetHash(), 0));
+        BOOST_CHECK_EQUAL(unspent[i].nHeight, (int)i + 1);
+        BOOST_CHECK_EQUAL(unspent[i].nValue, m_coinbase_txns[i]->vout[0].nValue);
+    }
+
+    // Pages pick up where the previous one left off.
+    BOOST_CHECK(addressindex.FindHistory(coinbase_script, 10, 5, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 5U);
+    BOOST_CHECK_EQUAL(history[0].nHeight, 11);
+    BOOST_CHECK(history[0].txid == m_coinbase_txns[10]->GetHash());
+    BOOST_CHECK(!history[0].fSpending);
+
+    // Spend the first coinbase output to another script.
+    const CAmount spend_value = 11 * CENT;
+    const CMutableTransaction spend = CreateCoinbaseSpend(0, spend_value, spend_script);
+
+    const CBlock block = CreateAndProcessBlock({spend}, coinbase_script);
+    BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    BOOST_CHECK(addressindex.BlockUntilSyncedToCurrentChain());
+
+    BOOST_CHECK(addressindex.FindUnspent(coinbase_script, 0, 1, unspent));
+    BOOST_CHECK(unspent[0].outpoint == COutPoint(m_coinbase_txns[1]->GetHash(), 0));
+    BOOST_CHECK(addressindex.FindHistory(coinbase_script, m_coinbase_txns.size(), 1000, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 2U);
+    BOOST_CHECK(!history[0].fSpending && history[0].txid == block.vtx[0]->GetHash());
+    BOOST_CHECK(history[1].fSpending && history[1].txid == spend.GetHash());
+    BOOST_CHECK_EQUAL(history[1].nValue, -m_coinbase_txns[0]->vout[0].nValue);
+    BOOST_CHECK(addressindex.GetBalance(spend_script, balance, received));
+    BOOST_CHECK_EQUAL(balance, spend_value);
+    BOOST_CHECK_EQUAL(received, spend_value);
+
+    // Replacing the block with one without the spend rewinds the index.
+    {
+        CValidationState state;
+        LOCK(cs_main);
+        InvalidateBlock(state, Params(), chainActive.Tip());
+    }
+    const CBlock block_replace = CreateAndProcessBlock({}, coinbase_script);
+    BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block_replace.GetHash());
+    BOOST_CHECK(addressindex.BlockUntilSyncedToCurrentChain());
+
+    BOOST_CHECK(addressindex.GetBalance(spend_script, balance, received));
+    BOOST_CHECK_EQUAL(balance, 0);
+    BOOST_CHECK_EQUAL(received, 0);
+    BOOST_CHECK(addressindex.FindUnspent(coinbase_script, 0, 1, unspent));
+    BOOST_CHECK(unspent[0].outpoint == COutPoint(m_coinbase_txns[0]->GetHash(), 0));
+    BOOST_CHECK(addressindex.FindHistory(coinbase_script, m_coinbase_txns.size(), 1000, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 1U);
+    BOOST_CHECK(history[0].txid == block_replace.vtx[0]->GetHash());
+
+    addressindex.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 
 #include <crypto/aes.h>
 #include <crypto/chacha20.h>
+#include <crypto/neoscrypt.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
@@ -562,4 +563,45 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(neoscrypt_n_way)
+{
+    // 13 inputs exercise the 8-way, 4-way and scalar paths in one call
+    static const unsigned int profiles[2] = {0x0, 0x3};
+    unsigned char in[80 * 13];
+    unsigned char out1[32 * 13], out2[32 * 13];
+    for (unsigned int profile : profiles) {
+        for (unsigned int j = 0; j < sizeof(in); ++j) {
+            in[j] = InsecureRandBits(8);
+        }
+        for (int j = 0; j < 13; ++j) {
+            neoscrypt(in + 80 * j, out1 + 32 * j, profile);
+        }
+        neoscrypt_N_way(in, out2, profile, 13);
+        BOOST_CHECK(memcmp(out1, out2, sizeof(out1)) == 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(neoscrypt_context)
+{
+    // Alternating profiles makes the scratchpad grow and then get reused
+    static const unsigned int profiles[4] = {0x0, 0x3, 0x0, 0x3};
+    unsigned char in[80];
+    unsigned char out1[32], out2[32];
+    for (unsigned int flags = 0; flags <= NEOSCRYPT_CTX_HUGEPAGES; ++flags) {
+        neoscrypt_ctx ctx;
+        neoscrypt_ctx_init(&ctx, flags);
+        for (unsigned int profile : profiles) {
+            for (unsigned int j = 0; j < sizeof(in); ++j) {
+                in[j] = InsecureRandBits(8);
+            }
+            neoscrypt(in, out1, profile);
+            BOOST_CHECK_EQUAL(neoscrypt_ctx_hash(&ctx, in, out2, profile), 0);
+            BOOST_CHECK(memcmp(out1, out2, sizeof(out1)) == 0);
+            BOOST_CHECK_EQUAL((size_t)ctx.scratchpad % 64, 0U);
+        }
+        neoscrypt_ctx_free(&ctx);
+        BOOST_CHECK(ctx.scratchpad == nullptr);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flat-database.h>
+#include <netbase.h>
+#include <netfulfilledman.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct FlatDBTestingSetup : public BasicTestingSetup {
+    FlatDBTestingSetup()
+    {
+        SetDataDir("flatdb");
+        ClearDatadirCache();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(flatdatabase_tests, FlatDBTestingSetup)
+
+static const std::string strFilename = "netfulfilled.dat";
+static const std::string strMagicMessage = "magicFulfilledCache";
+
+static std::vector<unsigned char> ReadDBFile()
+{
+    std::vector<unsigned char> vchData(fs::file_size(GetDataDir() / strFilename));
+    CAutoFile filein(fsbridge::fopen(GetDataDir() / strFilename, "rb"), SER_DISK, CLIENT_VERSION);
+    filein.read((char*)vchData.data(), vchData.size());
+    return vchData;
+}
+
+static void WriteDBFile(const std::vector<unsigned char>& vchData)
+{
+    CAutoFile fileout(fsbridge::fopen(GetDataDir() / strFilename, "wb"), SER_DISK, CLIENT_VERSION);
+    fileout.write((const char*)vchData.data(), vchData.size());
+}
+
+/// The whole file serialized in memory and checksummed in one go, the way it used to be written
+static std::vector<unsigned char> SerializeDBFile(const CNetFulfilledRequestManager& manager)
+{
+    CDataStream ssObj(SER_DISK, CLIENT_VERSION);
+    ssObj << strMagicMessage;
+    ssObj << Params().MessageStart();
+    ssObj << manager;
+    ssObj << Hash(ssObj.begin(), ssObj.end());
+    return std::vector<unsigned char>(ssObj.begin(), ssObj.end());
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_roundtrip)
+{
+    CService addr = LookupNumeric("1.2.3.4", 1234);
+    CNetFulfilledRequestManager manager;
+    manager.AddFulfilledRequest(addr, "request");
+
+    CFlatDB<CNetFulfilledRequestManager> flatdb(strFilename, strMagicMessage);
+    BOOST_CHECK(flatdb.Dump(manager));
+    // the stream is written exactly like the buffer used to be
+    BOOST_CHECK(ReadDBFile() == SerializeDBFile(manager));
+    BOOST_CHECK(!fs::exists(GetDataDir() / (strFilename + ".new")));
+
+    CNetFulfilledRequestManager managerLoaded;
+    BOOST_CHECK(flatdb.Load(managerLoaded));
+    BOOST_CHECK(managerLoaded.HasFulfilledRequest(addr, "request"));
+    BOOST_CHECK(!managerLoaded.HasFulfilledRequest(addr, "other request"));
+
+    // an existing file of ours gets replaced
+    manager.AddFulfilledRequest(addr, "other request");
+    BOOST_CHECK(flatdb.Dump(manager));
+    CNetFulfilledRequestManager managerReloaded;
+    BOOST_CHECK(flatdb.Load(managerReloaded));
+    BOOST_CHECK(managerReloaded.HasFulfilledRequest(addr, "other request"));
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_corrupted)
+{
+    CService addr = LookupNumeric("1.2.3.4", 1234);
+    CNetFulfilledRequestManager manager;
+    manager.AddFulfilledRequest(addr, "request");
+    CFlatDB<CNetFulfilledRequestManager> flatdb(strFilename, strMagicMessage);
+
+    // a flipped bit fails the checksum, the file is left for the user to fix
+    std::vector<unsigned char> vchData = SerializeDBFile(manager);
+    vchData[vchData.size() - sizeof(uint256) - 1] ^= 1;
+    WriteDBFile(vchData);
+    CNetFulfilledRequestManager managerLoaded;
+    BOOST_CHECK(!flatdb.Load(managerLoaded));
+    BOOST_CHECK(!managerLoaded.HasFulfilledRequest(addr, "request"));
+    BOOST_CHECK(!flatdb.Dump(manager));
+    BOOST_CHECK(ReadDBFile() == vchData);
+
+    // and so does trailing data
+    vchData = SerializeDBFile(manager);
+    vchData.insert(vchData.end() - sizeof(uint256), 0);
+    WriteDBFile(vchData);
+    BOOST_CHECK(!flatdb.Load(managerLoaded));
+
+    // intact data in a format we can't read is recreated
+    CDataStream ssObj(SER_DISK, CLIENT_VERSION);
+    ssObj << strMagicMessage;
+    ssObj << Params().MessageStart();
+    ssObj << std::vector<unsigned char>(100, 0xff);
+    ssObj << Hash(ssObj.begin(), ssObj.end());
+    WriteDBFile(std::vector<unsigned char>(ssObj.begin(), ssObj.end()));
+    BOOST_CHECK(flatdb.Load(managerLoaded));
+    BOOST_CHECK(!managerLoaded.HasFulfilledRequest(addr, "request"));
+    BOOST_CHECK(flatdb.Dump(manager));
+    BOOST_CHECK(ReadDBFile() == SerializeDBFile(manager));
+
+    // another type of file is left alone
+    CFlatDB<CNetFulfilledRequestManager> flatdbOther(strFilename, "magicOtherCache");
+    BOOST_CHECK(!flatdbOther.Load(managerLoaded));
+    BOOST_CHECK(!flatdbOther.Dump(manager));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternodeman.h>
+#include <netbase.h>
+#include <script/standard.h>
+#include <streams.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(masternodeman_tests, BasicTestingSetup)
+
+static CPubKey NewPubKey()
+{
+    CKey key;
+    key.MakeNewKey(true);
+    return key.GetPubKey();
+}
+
+BOOST_AUTO_TEST_CASE(masternodeman_indexes)
+{
+    CMasternodeMan mnman;
+
+    const CPubKey pubKeyCollateral = NewPubKey();
+    const CPubKey pubKeyMasternode1 = NewPubKey();
+    const CPubKey pubKeyMasternode2 = NewPubKey();
+    const COutPoint outpoint1(InsecureRand256(), 0);
+    const COutPoint outpoint2(InsecureRand256(), 1);
+    const COutPoint outpointLow = std::min(outpoint1, outpoint2);
+
+    // Both masternodes are paid to the same collateral address
+    CMasternode mn1(LookupNumeric("1.2.3.4", 9999), outpoint1, pubKeyCollateral, pubKeyMasternode1, PROTOCOL_VERSION);
+    CMasternode mn2(LookupNumeric("1.2.3.5", 9999), outpoint2, pubKeyCollateral, pubKeyMasternode2, PROTOCOL_VERSION);
+    BOOST_CHECK(mnman.Add(mn1));
+    BOOST_CHECK(mnman.Add(mn2));
+    BOOST_CHECK(!mnman.Add(mn1));
+
+    masternode_info_t info;
+    BOOST_CHECK(mnman.GetMasternodeInfo(pubKeyMasternode1, info));
+    BOOST_CHECK(info.outpoint == outpoint1);
+    BOOST_CHECK(mnman.GetMasternodeInfo(pubKeyMasternode2, info));
+    BOOST_CHECK(info.outpoint == outpoint2);
+    BOOST_CHECK(!mnman.GetMasternodeInfo(NewPubKey(), info));
+
+    // A shared payee resolves to the lowest outpoint, like a scan of the list would
+    const CScript payee = GetScriptForDestination(pubKeyCollateral.GetID());
+    BOOST_CHECK(mnman.GetMasternodeInfo(payee, info));
+    BOOST_CHECK(info.outpoint == outpointLow);
+    // Only the P2PKH script of the collateral key is a masternode payee
+    BOOST_CHECK(!mnman.GetMasternodeInfo(GetScriptForRawPubKey(pubKeyCollateral), info));
+
+    std::vector<COutPoint> vecOutpoints;
+    mnman.ForEachMasternode([&](const CMasternode& mn) { vecOutpoints.push_back(mn.outpoint); });
+    BOOST_CHECK_EQUAL(vecOutpoints.size(), 2U);
+    BOOST_CHECK(vecOutpoints[0] == outpointLow);
+
+    // Indexes are rebuilt when the list is loaded from disk
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << mnman;
+    CMasternodeMan mnmanLoaded;
+    ss >> mnmanLoaded;
+    BOOST_CHECK(mnmanLoaded.GetMasternodeInfo(pubKeyMasternode2, info));
+    BOOST_CHECK(info.outpoint == outpoint2);
+    BOOST_CHECK(mnmanLoaded.GetMasternodeInfo(payee, info));
+    BOOST_CHECK(info.outpoint == outpointLow);
+
+    mnman.Clear();
+    BOOST_CHECK(!mnman.GetMasternodeInfo(pubKeyMasternode1, info));
+    BOOST_CHECK(!mnman.GetMasternodeInfo(payee, info));
+}
+
+BOOST_AUTO_TEST_CASE(masternodeman_list_snapshot)
+{
+    CMasternodeMan mnman;
+    CMasternode mn1(LookupNumeric("1.2.3.4", 9999), COutPoint(InsecureRand256(), 0), NewPubKey(), NewPubKey(), PROTOCOL_VERSION);
+    CMasternode mn2(LookupNumeric("1.2.3.5", 9999), COutPoint(InsecureRand256(), 0), NewPubKey(), NewPubKey(), PROTOCOL_VERSION);
+    BOOST_CHECK(mnman.Add(mn1));
+
+    // readers share one snapshot until the list changes
+    auto pSnapshot = mnman.GetListSnapshot();
+    BOOST_CHECK_EQUAL(pSnapshot->size(), 1U);
+    BOOST_CHECK(mnman.GetListSnapshot() == pSnapshot);
+
+    // a reader holding an old snapshot isn't affected by changes
+    BOOST_CHECK(mnman.Add(mn2));
+    BOOST_CHECK(mnman.DisallowMixing(mn1.outpoint));
+    auto pSnapshotNew = mnman.GetListSnapshot();
+    BOOST_CHECK(pSnapshotNew != pSnapshot);
+    BOOST_CHECK_EQUAL(pSnapshot->size(), 1U);
+    BOOST_CHECK(pSnapshot->at(0).fAllowMixingTx);
+    BOOST_CHECK_EQUAL(pSnapshotNew->size(), 2U);
+    BOOST_CHECK(pSnapshotNew->at(0).outpoint < pSnapshotNew->at(1).outpoint);
+    for (const auto& mn : *pSnapshotNew) {
+        BOOST_CHECK_EQUAL(mn.fAllowMixingTx, mn.outpoint != mn1.outpoint);
+    }
+
+    mnman.Clear();
+    BOOST_CHECK(mnman.GetListSnapshot()->empty());
+    BOOST_CHECK_EQUAL(pSnapshotNew->size(), 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
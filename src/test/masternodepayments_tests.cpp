@@ -0,0 +1,64 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-payments.h>
+#include <script/standard.h>
+#include <streams.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(masternodepayments_tests, BasicTestingSetup)
+
+static CScript NewPayee()
+{
+    CKey key;
+    key.MakeNewKey(true);
+    return GetScriptForDestination(key.GetPubKey().GetID());
+}
+
+static void Vote(CMasternodeBlockPayees& blockPayees, const CScript& payee)
+{
+    blockPayees.AddPayee(CMasternodePaymentVote(COutPoint(InsecureRand256(), 0), blockPayees.nBlockHeight, payee));
+}
+
+BOOST_AUTO_TEST_CASE(masternodepayments_tally)
+{
+    LOCK(cs_mapMasternodeBlocks);
+
+    CMasternodeBlockPayees blockPayees(100);
+    const CScript payee1 = NewPayee();
+    const CScript payee2 = NewPayee();
+    CScript payeeRet;
+
+    BOOST_CHECK(!blockPayees.GetBestPayee(payeeRet));
+
+    // payee2 gets ahead, payee1 catches up and wins the tie by coming first
+    Vote(blockPayees, payee1);
+    Vote(blockPayees, payee2);
+    Vote(blockPayees, payee2);
+    BOOST_CHECK(blockPayees.GetBestPayee(payeeRet) && payeeRet == payee2);
+    Vote(blockPayees, payee1);
+    BOOST_CHECK(blockPayees.GetBestPayee(payeeRet) && payeeRet == payee1);
+    BOOST_CHECK_EQUAL(blockPayees.vecPayees.size(), 2U);
+
+    BOOST_CHECK(blockPayees.HasPayeeWithVotes(payee2, 2));
+    BOOST_CHECK(!blockPayees.HasPayeeWithVotes(payee2, 3));
+    BOOST_CHECK(!blockPayees.HasPayeeWithVotes(NewPayee(), 0));
+
+    // the tally is rebuilt when read back
+    Vote(blockPayees, payee2);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << blockPayees;
+    CMasternodeBlockPayees blockPayeesRead;
+    ss >> blockPayeesRead;
+    BOOST_CHECK(blockPayeesRead.GetBestPayee(payeeRet) && payeeRet == payee2);
+    BOOST_CHECK(blockPayeesRead.HasPayeeWithVotes(payee1, 2));
+    Vote(blockPayeesRead, payee1);
+    BOOST_CHECK_EQUAL(blockPayeesRead.vecPayees.size(), 2U);
+    BOOST_CHECK_EQUAL(blockPayeesRead.vecPayees[0].GetVoteCount(), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <messagedispatcher.h>
+#include <net.h>
+
+#include <test/test_bitcoin.h>
+
+#include <future>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(messagedispatcher_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(dispatcher_order)
+{
+    const int nNodes = 5;
+    std::vector<std::unique_ptr<CNode> > vNodes;
+    for (int i = 0; i < nNodes; i++) {
+        vNodes.emplace_back(new CNode(i, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", true));
+    }
+
+    CMessageDispatcher dispatcher;
+    std::vector<std::vector<int> > vOrder(nNodes);
+
+    // not started, tasks run right away
+    dispatcher.Push(vNodes[0].get(), [&](CNode* pfrom) {
+        BOOST_CHECK(pfrom == vNodes[0].get());
+        vOrder[0].push_back(-1);
+    });
+    BOOST_CHECK_EQUAL(vOrder[0].size(), 1U);
+    vOrder[0].clear();
+
+    // each node keeps to one thread, so its tasks need no lock of their own
+    dispatcher.Start(3);
+    const int nTasks = 200;
+    std::vector<std::promise<void> > vDone(nNodes);
+    for (int i = 0; i < nTasks; i++) {
+        for (int n = 0; n < nNodes; n++) {
+            dispatcher.Push(vNodes[n].get(), [&, i, n](CNode* pfrom) {
+                if (pfrom == vNodes[n].get()) vOrder[n].push_back(i);
+                if (i == nTasks - 1) vDone[n].set_value();
+            });
+        }
+    }
+    for (int n = 0; n < nNodes; n++) {
+        BOOST_CHECK(vDone[n].get_future().wait_for(std::chrono::seconds(60)) == std::future_status::ready);
+    }
+
+    // a disconnected node's tasks are dropped, node 3 shares its thread and runs after them
+    std::promise<void> doneOther;
+    vNodes[0]->fDisconnect = true;
+    dispatcher.Push(vNodes[0].get(), [&](CNode* pfrom) { vOrder[0].push_back(-1); });
+    dispatcher.Push(vNodes[3].get(), [&](CNode* pfrom) { doneOther.set_value(); });
+    BOOST_CHECK(doneOther.get_future().wait_for(std::chrono::seconds(60)) == std::future_status::ready);
+
+    // a queued or running task counts as pending on its node until it is done
+    std::promise<void> release, doneBlocked;
+    std::shared_future<void> released(release.get_future());
+    dispatcher.Push(vNodes[1].get(), [&, released](CNode* pfrom) { released.wait(); });
+    dispatcher.Push(vNodes[1].get(), [&](CNode* pfrom) { doneBlocked.set_value(); });
+    BOOST_CHECK_EQUAL(vNodes[1]->nPendingMessages, 2);
+    release.set_value();
+    BOOST_CHECK(doneBlocked.get_future().wait_for(std::chrono::seconds(60)) == std::future_status::ready);
+    dispatcher.Stop();
+
+    for (int n = 0; n < nNodes; n++) {
+        BOOST_CHECK_EQUAL(vOrder[n].size(), (size_t)nTasks);
+        for (int i = 0; i < (int)vOrder[n].size(); i++) {
+            BOOST_CHECK_EQUAL(vOrder[n][i], i);
+        }
+        BOOST_CHECK_EQUAL(vNodes[n]->GetRefCount(), 0);
+        BOOST_CHECK_EQUAL(vNodes[n]->nPendingMessages, 0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
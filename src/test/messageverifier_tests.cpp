@@ -0,0 +1,166 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <messageverifier.h>
+#include <net.h>
+
+#include <test/test_bitcoin.h>
+
+#include <future>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(messageverifier_tests, BasicTestingSetup)
+
+struct TestMessage
+{
+    std::string strMessage;
+    std::vector<unsigned char> vchSig;
+    CRecoveredSigner recoveredSigner;
+};
+
+static std::shared_ptr<TestMessage> SignTestMessage(const CKey& key, const std::string& strMessage)
+{
+    auto pmsg = std::make_shared<TestMessage>();
+    pmsg->strMessage = strMessage;
+    BOOST_CHECK(CMessageSigner::SignMessage(strMessage, pmsg->vchSig, key));
+    return pmsg;
+}
+
+BOOST_AUTO_TEST_CASE(recovered_signer)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    std::string strError;
+
+    auto pmsg = SignTestMessage(key, "message");
+    CMessageSigCheck check(pmsg->strMessage, pmsg->vchSig, pmsg->recoveredSigner);
+    BOOST_CHECK(check());
+    BOOST_CHECK(pmsg->recoveredSigner.keyID == key.GetPubKey().GetID());
+    BOOST_CHECK(CMessageSigner::VerifyMessage(key.GetPubKey(), pmsg->vchSig, pmsg->strMessage, strError, &pmsg->recoveredSigner));
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(keyOther.GetPubKey(), pmsg->vchSig, pmsg->strMessage, strError, &pmsg->recoveredSigner));
+
+    // a signer recovered for another message or signature is ignored
+    CRecoveredSigner forged = pmsg->recoveredSigner;
+    forged.keyID = keyOther.GetPubKey().GetID();
+    BOOST_CHECK(!forged.Matches(CMessageSigner::GetMessageHash("other message"), pmsg->vchSig));
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(keyOther.GetPubKey(), pmsg->vchSig, "other message", strError, &forged));
+    auto pmsgOther = SignTestMessage(keyOther, "message");
+    BOOST_CHECK(CMessageSigner::VerifyMessage(keyOther.GetPubKey(), pmsgOther->vchSig, pmsg->strMessage, strError, &pmsg->recoveredSigner));
+
+    // garbage leaves nothing recovered
+    auto pmsgBad = SignTestMessage(key, "message");
+    pmsgBad->vchSig.resize(10);
+    CMessageSigCheck checkBad(pmsgBad->strMessage, pmsgBad->vchSig, pmsgBad->recoveredSigner);
+    BOOST_CHECK(checkBad());
+    BOOST_CHECK(pmsgBad->recoveredSigner.hashSigned.IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(message_sig_cache)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    std::string strError;
+
+    auto pmsg = SignTestMessage(key, "cached message");
+    for (int i = 0; i < 2; i++) {
+        // a cached signature is valid for its own key only
+        BOOST_CHECK(CMessageSigner::VerifyMessageCached(key.GetPubKey(), pmsg->vchSig, pmsg->strMessage, strError));
+        BOOST_CHECK(!CMessageSigner::VerifyMessageCached(keyOther.GetPubKey(), pmsg->vchSig, pmsg->strMessage, strError));
+        BOOST_CHECK(!CMessageSigner::VerifyMessageCached(key.GetPubKey(), pmsg->vchSig, "other message", strError));
+    }
+
+    // and everything still gets verified with the smallest cache
+    gArgs.ForceSetArg("-mnsigcachesize", "0");
+    InitMessageSigCache();
+    BOOST_CHECK(CMessageSigner::VerifyMessageCached(key.GetPubKey(), pmsg->vchSig, pmsg->strMessage, strError));
+    BOOST_CHECK(!CMessageSigner::VerifyMessageCached(keyOther.GetPubKey(), pmsg->vchSig, pmsg->strMessage, strError));
+    gArgs.ForceSetArg("-mnsigcachesize", std::to_string(DEFAULT_MN_SIG_CACHE_SIZE));
+    InitMessageSigCache();
+}
+
+BOOST_AUTO_TEST_CASE(sig_check_cache)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    std::string strError;
+
+    // recovering for the expected signer fills the cache used by VerifyMessageCached
+    auto pmsg = SignTestMessage(key, "expected signer");
+    CMessageSigCheck check(pmsg->strMessage, pmsg->vchSig, pmsg->recoveredSigner, key.GetPubKey().GetID());
+    BOOST_CHECK(check());
+    BOOST_CHECK(pmsg->recoveredSigner.keyID == key.GetPubKey().GetID());
+
+    // and a copy of the message is then served from it
+    auto pmsgCopy = std::make_shared<TestMessage>(*pmsg);
+    pmsgCopy->recoveredSigner = CRecoveredSigner();
+    CMessageSigCheck checkCopy(pmsgCopy->strMessage, pmsgCopy->vchSig, pmsgCopy->recoveredSigner, key.GetPubKey().GetID());
+    BOOST_CHECK(checkCopy());
+    BOOST_CHECK(pmsgCopy->recoveredSigner.Matches(CMessageSigner::GetMessageHash(pmsgCopy->strMessage), pmsgCopy->vchSig));
+    BOOST_CHECK(pmsgCopy->recoveredSigner.keyID == key.GetPubKey().GetID());
+    BOOST_CHECK(CMessageSigner::VerifyMessage(key.GetPubKey(), pmsgCopy->vchSig, pmsgCopy->strMessage, strError, &pmsgCopy->recoveredSigner));
+
+    // expecting someone else still recovers the real signer
+    auto pmsgOther = SignTestMessage(key, "unexpected signer");
+    CMessageSigCheck checkOther(pmsgOther->strMessage, pmsgOther->vchSig, pmsgOther->recoveredSigner, keyOther.GetPubKey().GetID());
+    BOOST_CHECK(checkOther());
+    BOOST_CHECK(pmsgOther->recoveredSigner.keyID == key.GetPubKey().GetID());
+    BOOST_CHECK(!CMessageSigner::VerifyMessage(keyOther.GetPubKey(), pmsgOther->vchSig, pmsgOther->strMessage, strError, &pmsgOther->recoveredSigner));
+}
+
+BOOST_AUTO_TEST_CASE(verifier_order)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", true);
+
+    CMessageVerifier verifier;
+    std::vector<int> vOrder;
+    std::vector<bool> vValid;
+
+    // not started, continuations run right away
+    {
+        auto pmsg = SignTestMessage(key, "inline");
+        std::vector<CMessageSigCheck> vChecks;
+        vChecks.emplace_back(pmsg->strMessage, pmsg->vchSig, pmsg->recoveredSigner);
+        verifier.Push(&node, vChecks, [&](CNode* pfrom) {
+            BOOST_CHECK(pfrom == &node);
+            BOOST_CHECK(pmsg->recoveredSigner.keyID == key.GetPubKey().GetID());
+            vOrder.push_back(-1);
+        });
+        BOOST_CHECK_EQUAL(vOrder.size(), 1U);
+    }
+
+    verifier.Start();
+    std::promise<void> done;
+    const int nJobs = 50;
+    for (int i = 0; i < nJobs; i++) {
+        auto pmsg = SignTestMessage(key, "message " + std::to_string(i));
+        std::vector<CMessageSigCheck> vChecks;
+        vChecks.emplace_back(pmsg->strMessage, pmsg->vchSig, pmsg->recoveredSigner);
+        // runs on the verifier thread, results are checked below
+        verifier.Push(&node, vChecks, [&, pmsg, i](CNode* pfrom) {
+            vValid.push_back(pfrom == &node && pmsg->recoveredSigner.Matches(CMessageSigner::GetMessageHash(pmsg->strMessage), pmsg->vchSig) &&
+                             pmsg->recoveredSigner.keyID == key.GetPubKey().GetID());
+            vOrder.push_back(i);
+            if (i == nJobs - 1) done.set_value();
+        });
+    }
+    BOOST_CHECK(done.get_future().wait_for(std::chrono::seconds(60)) == std::future_status::ready);
+    verifier.Stop();
+
+    BOOST_CHECK_EQUAL(vOrder.size(), (size_t)nJobs + 1);
+    BOOST_CHECK_EQUAL(vValid.size(), (size_t)nJobs);
+    for (int i = 0; i < nJobs; i++) {
+        BOOST_CHECK_EQUAL(vOrder[i + 1], i);
+        BOOST_CHECK(vValid[i]);
+    }
+    BOOST_CHECK_EQUAL(node.GetRefCount(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -11,6 +11,7 @@
 #include <validation.h>
 #include <miner.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <pubkey.h>
 #include <script/standard.h>
 #include <txmempool.h>
@@ -521,4 +522,42 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_AUTO_TEST_CASE(SolveBlockHeader_test)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::REGTEST);
+    const Consensus::Params& params = chainParams->GetConsensus();
+
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.nTime = params.nNeoScryptFork;
+    // Roughly one in 16 hashes meets this, enough to exercise the batching
+    header.nBits = 0x200fffff;
+
+    for (int i = 0; i < 4; i++) {
+        header.hashMerkleRoot = InsecureRand256();
+        header.nNonce = 0;
+
+        CBlockHeader single(header);
+        uint64_t nTriesSingle = 1000;
+        BOOST_CHECK(SolveBlockHeader(&single, 0x10000, nTriesSingle, 1, params));
+        BOOST_CHECK(CheckProofOfWork(single.GetPoWHash(GetPoWProfile(single, params)), single.nBits, params));
+        BOOST_CHECK_EQUAL(nTriesSingle, 1000U - single.nNonce);
+
+        // Several threads must settle on the same, lowest nonce
+        CBlockHeader multi(header);
+        uint64_t nTriesMulti = 1000;
+        BOOST_CHECK(SolveBlockHeader(&multi, 0x10000, nTriesMulti, 3, params));
+        BOOST_CHECK_EQUAL(multi.nNonce, single.nNonce);
+        BOOST_CHECK_EQUAL(nTriesMulti, nTriesSingle);
+    }
+
+    // Running out of tries reports failure and uses up the budget
+    header.nBits = 0x1d00ffff;
+    header.nNonce = 0;
+    uint64_t nTries = 5;
+    BOOST_CHECK(!SolveBlockHeader(&header, 0x10000, nTries, 2, params));
+    BOOST_CHECK_EQUAL(nTries, 0U);
+    BOOST_CHECK_EQUAL(header.nNonce, 5U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
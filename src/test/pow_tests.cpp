@@ -83,4 +83,33 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(GetPoWHashes_test)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+
+    // One header on each side of the NeoScrypt fork, plus enough to fill every kernel
+    std::vector<CBlockHeader> headers(11);
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].nVersion = 2;
+        headers[i].hashPrevBlock = InsecureRand256();
+        headers[i].hashMerkleRoot = InsecureRand256();
+        headers[i].nTime = params.nNeoScryptFork - 1 + (i % 2);
+        headers[i].nBits = 0x207fffff;
+        headers[i].nNonce = InsecureRand32();
+    }
+    BOOST_CHECK_EQUAL(GetPoWProfile(headers[0], params), 0x3U);
+    BOOST_CHECK_EQUAL(GetPoWProfile(headers[1], params), 0x0U);
+
+    for (unsigned int profile : {0x0U, 0x3U}) {
+        std::vector<const CBlockHeader*> vHeaders;
+        for (const CBlockHeader& header : headers) vHeaders.push_back(&header);
+        std::vector<uint256> hashes = GetPoWHashes(vHeaders, profile);
+        BOOST_CHECK_EQUAL(hashes.size(), headers.size());
+        for (size_t i = 0; i < headers.size(); i++) {
+            BOOST_CHECK(hashes[i] == headers[i].GetPoWHash(profile));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,61 @@
+// Copyright (c) 2019 The Guncoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/spentindex.h>
+#include <script/standard.h>
+#include <test/test_bitcoin.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(spentindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(spentindex_reorg, TestChain100Setup)
+{
+    SpentIndex spentindex(1 << 20, true);
+
+    // Spend the first coinbase output before the index is started.
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const COutPoint outpoint(m_coinbase_txns[0]->GetHash(), 0);
+    const CMutableTransaction spend = CreateCoinbaseSpend(0, 11 * CENT, coinbase_script);
+
+    CreateAndProcessBlock({spend}, coinbase_script);
+    const int spend_height = chainActive.Height();
+
+    spentindex.Start();
+
+    // Allow spent index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!spentindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    CSpentIndexEntry entry;
+    BOOST_CHECK(spentindex.FindSpent(outpoint, entry));
+    BOOST_CHECK(entry.txid == spend.GetHash());
+    BOOST_CHECK_EQUAL(entry.nInputIndex, 0U);
+    BOOST_CHECK_EQUAL(entry.nHeight, spend_height);
+    BOOST_CHECK(!spentindex.FindSpent(COutPoint(m_coinbase_txns[1]->GetHash(), 0), entry));
+
+    // Replacing the block with one without the spend rewinds the index.
+    {
+        CValidationState state;
+        LOCK(cs_main);
+        InvalidateBlock(state, Params(), chainActive.Tip());
+    }
+    CreateAndProcessBlock({}, coinbase_script);
+    BOOST_REQUIRE_EQUAL(chainActive.Height(), spend_height);
+    BOOST_CHECK(spentindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(!spentindex.FindSpent(outpoint, entry));
+
+    spentindex.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,8 +7,10 @@
 #include <chainparams.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <crypto/neoscrypt.h>
 #include <crypto/sha256.h>
 #include <validation.h>
+#include <messagesigner.h>
 #include <miner.h>
 #include <net_processing.h>
 #include <pow.h>
@@ -16,6 +18,7 @@
 #include <streams.h>
 #include <rpc/server.h>
 #include <rpc/register.h>
+#include <script/interpreter.h>
 #include <script/sigcache.h>
 
 void CConnmanTest::AddNode(CNode& node)
@@ -49,12 +52,15 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
     : m_path_root(fs::temp_directory_path() / "test_bitcoin" / strprintf("%lu_%i", (unsigned long)GetTime(), (int)(InsecureRandRange(1 << 30))))
 {
     SHA256AutoDetect();
+    neoscrypt_autodetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
     SetupNetworking();
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitPoWCache();
+    InitMessageSigCache();
     fCheckBlockIndex = true;
     SelectParams(chainName);
     noui_connect();
@@ -171,6 +177,24 @@ TestChain100Setup::CreateAndProcessBlock(const std::vector<CMutableTransaction>&
     return result;
 }
 
+CMutableTransaction
+TestChain100Setup::CreateCoinbaseSpend(size_t nCoinbase, const CAmount& nValue, const CScript& scriptPubKey)
+{
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[nCoinbase]->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = nValue;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    coinbaseKey.Sign(hash, vchSig);
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+    return spend;
+}
+
 TestChain100Setup::~TestChain100Setup()
 {
 }
@@ -89,6 +89,10 @@ struct TestChain100Setup : public TestingSetup {
     CBlock CreateAndProcessBlock(const std::vector<CMutableTransaction>& txns,
                                  const CScript& scriptPubKey);
 
+    // Create a transaction spending the output of m_coinbase_txns[nCoinbase]
+    // to nValue paid to scriptPubKey, signed with coinbaseKey.
+    CMutableTransaction CreateCoinbaseSpend(size_t nCoinbase, const CAmount& nValue, const CScript& scriptPubKey);
+
     ~TestChain100Setup();
 
     std::vector<CTransactionRef> m_coinbase_txns; // For convenience, coinbase transactions
@@ -0,0 +1,57 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <unordered_lru_cache.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(unordered_lru_cache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(unordered_lru_cache_test)
+{
+    // create a cache capped at 3 items
+    unordered_lru_cache<int, int> cache(3);
+    BOOST_CHECK(cache.max_size() == 3);
+    BOOST_CHECK(cache.empty());
+    BOOST_CHECK(cache.get(1) == nullptr);
+
+    for (int i = 1; i <= 3; i++) {
+        cache.insert(i, i * 10);
+    }
+    BOOST_CHECK(cache.size() == 3);
+
+    // touch 1 so that 2 becomes the least recently used entry
+    const int* pvalue = cache.get(1);
+    BOOST_CHECK(pvalue != nullptr && *pvalue == 10);
+
+    cache.insert(4, 40);
+    BOOST_CHECK(cache.size() == 3);
+    BOOST_CHECK(cache.count(2) == 0);
+    BOOST_CHECK(cache.count(1) == 1);
+    BOOST_CHECK(cache.count(3) == 1);
+    BOOST_CHECK(cache.count(4) == 1);
+
+    // replacing a value doesn't grow the cache but refreshes the entry
+    cache.insert(3, 31);
+    BOOST_CHECK(cache.size() == 3);
+    pvalue = cache.get(3);
+    BOOST_CHECK(pvalue != nullptr && *pvalue == 31);
+
+    // 1 is now the oldest
+    cache.insert(5, 50);
+    BOOST_CHECK(cache.count(1) == 0);
+    BOOST_CHECK(cache.count(4) == 1);
+
+    cache.erase(4);
+    BOOST_CHECK(cache.size() == 2);
+    BOOST_CHECK(cache.get(4) == nullptr);
+
+    cache.clear();
+    BOOST_CHECK(cache.empty());
+    BOOST_CHECK(cache.get(5) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
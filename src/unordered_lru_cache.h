@@ -0,0 +1,83 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UNORDERED_LRU_CACHE_H
+#define BITCOIN_UNORDERED_LRU_CACHE_H
+
+#include <assert.h>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/** Hash map that keeps at most N elements, evicting the least recently used one. */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class unordered_lru_cache
+{
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const key_type, mapped_type> value_type;
+    typedef typename std::list<value_type>::size_type size_type;
+
+protected:
+    // most recently used first
+    std::list<value_type> list;
+    typedef typename std::list<value_type>::iterator iterator;
+    std::unordered_map<K, iterator, Hash> map;
+    size_type nMaxSize;
+
+public:
+    explicit unordered_lru_cache(size_type nMaxSizeIn)
+    {
+        assert(nMaxSizeIn > 0);
+        nMaxSize = nMaxSizeIn;
+    }
+    size_type size() const { return list.size(); }
+    bool empty() const { return list.empty(); }
+    size_type count(const key_type& k) const { return map.count(k); }
+    size_type max_size() const { return nMaxSize; }
+
+    /** Return the value for k and mark it as most recently used, or nullptr.
+     *  The pointer is invalidated by the next modification of the cache. */
+    const mapped_type* get(const key_type& k)
+    {
+        auto it = map.find(k);
+        if (it == map.end())
+            return nullptr;
+        list.splice(list.begin(), list, it->second);
+        return &it->second->second;
+    }
+    /** Insert or replace the value for k, evicting the least recently used entry if full. */
+    void insert(const key_type& k, mapped_type v)
+    {
+        auto it = map.find(k);
+        if (it != map.end()) {
+            it->second->second = std::move(v);
+            list.splice(list.begin(), list, it->second);
+            return;
+        }
+        if (list.size() == nMaxSize) {
+            map.erase(list.back().first);
+            list.pop_back();
+        }
+        list.emplace_front(k, std::move(v));
+        map.emplace(k, list.begin());
+    }
+    void erase(const key_type& k)
+    {
+        auto it = map.find(k);
+        if (it == map.end())
+            return;
+        list.erase(it->second);
+        map.erase(it);
+    }
+    void clear()
+    {
+        map.clear();
+        list.clear();
+    }
+};
+
+#endif // BITCOIN_UNORDERED_LRU_CACHE_H
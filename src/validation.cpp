@@ -16,6 +16,7 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <cuckoocache.h>
 #include <hash.h>
 #include <index/txindex.h>
@@ -27,6 +28,7 @@
 #include <primitives/transaction.h>
 #include <random.h>
 #include <reverse_iterator.h>
+#include <saltedcuckoocache.h>
 #include <script/script.h>
 #include <script/sigcache.h>
 #include <script/standard.h>
@@ -48,8 +50,13 @@
 #include <masternode-payments.h>
 
 #include <future>
+#include <list>
 #include <sstream>
 
+#ifndef WIN32
+#include <sys/stat.h>
+#endif
+
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/thread.hpp>
 
@@ -170,7 +177,7 @@ public:
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to mapBlockIndex.
      */
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Block (dis)connection on a given view:
@@ -235,6 +242,7 @@ bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
+bool fBlockMmap = DEFAULT_BLOCK_MMAP;
 size_t nCoinCacheUsage = 5000 * 300;
 uint64_t nPruneTarget = 0;
 bool fAlerts = DEFAULT_ALERTS;
@@ -1111,6 +1119,165 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
 // CBlock and CBlockIndex
 //
 
+/** Block and undo files kept mapped for reading */
+static const size_t MAX_MAPPED_BLOCK_FILES = sizeof(void*) > 4 ? 32 : 4;
+
+/**
+ * A block or undo file mapped read-only into memory. Records are read straight
+ * from the mapping, which stays in place for as long as a reader holds on to
+ * it, even after the cache dropped it.
+ */
+class CMappedBlockFile
+{
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+
+public:
+    CMappedBlockFile(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+    CMappedBlockFile(const CMappedBlockFile&) = delete;
+    CMappedBlockFile& operator=(const CMappedBlockFile&) = delete;
+
+    ~CMappedBlockFile()
+    {
+#ifndef WIN32
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    }
+
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
+
+/**
+ * The most recently used mappings of block and undo files. A mapping is dropped
+ * whenever its file is written, truncated or pruned, so that it never covers
+ * bytes which changed underneath it or which no longer exist.
+ */
+class CBlockFileMapCache
+{
+private:
+    typedef std::pair<std::string, int> FileKey;
+
+    CCriticalSection cs;
+    //! Most recently used first
+    std::list<std::pair<FileKey, std::shared_ptr<const CMappedBlockFile>>> lru GUARDED_BY(cs);
+
+    static std::shared_ptr<const CMappedBlockFile> Map(const fs::path& path, uint64_t nMinSize)
+    {
+#ifndef WIN32
+        int fd = open(path.string().c_str(), O_RDONLY);
+        if (fd == -1)
+            return nullptr;
+        struct stat st;
+        void* addr = MAP_FAILED;
+        size_t nSize = 0;
+        if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size >= nMinSize) {
+            nSize = st.st_size;
+            addr = mmap(nullptr, nSize, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (addr == MAP_FAILED)
+            return nullptr;
+        return std::make_shared<const CMappedBlockFile>(static_cast<const unsigned char*>(addr), nSize);
+#else
+        // Reads go through OpenDiskFile instead.
+        return nullptr;
+#endif
+    }
+
+public:
+    /** Get a mapping of the file at least nMinSize long, or null if the file can't be mapped or is shorter */
+    std::shared_ptr<const CMappedBlockFile> Get(int nFile, const char* prefix, uint64_t nMinSize)
+    {
+        const FileKey key(prefix, nFile);
+        LOCK(cs);
+        for (auto it = lru.begin(); it != lru.end(); ++it) {
+            if (it->first != key)
+                continue;
+            if (it->second->size() >= nMinSize) {
+                lru.splice(lru.begin(), lru, it);
+                return lru.front().second;
+            }
+            lru.erase(it);
+            break;
+        }
+
+        std::shared_ptr<const CMappedBlockFile> map = Map(GetBlockPosFilename(CDiskBlockPos(nFile, 0), prefix), nMinSize);
+        if (!map)
+            return nullptr;
+        lru.emplace_front(key, map);
+        if (lru.size() > MAX_MAPPED_BLOCK_FILES)
+            lru.pop_back();
+        return map;
+    }
+
+    /** Drop the mappings of a file number, of both block and undo files unless prefix is given */
+    void Invalidate(int nFile, const char* prefix = nullptr)
+    {
+        LOCK(cs);
+        lru.remove_if([&](const std::pair<FileKey, std::shared_ptr<const CMappedBlockFile>>& entry) {
+            return entry.first.second == nFile && (!prefix || entry.first.first == prefix);
+        });
+    }
+};
+
+static CBlockFileMapCache blockFileMaps;
+
+/**
+ * How much of a block or undo file was written by this node and is still on
+ * disk. A stream read of a file that got truncated or failed underneath the
+ * node returns an error, but touching a page of a mapping past the end of its
+ * file raises SIGBUS and kills the node, so mapped reads stay within this.
+ * That still leaves the window between the check and the read itself; nodes
+ * whose block files may be changed by something else should run with
+ * -blockmmap=0.
+ */
+static uint64_t GetDiskFileAvailable(int nFile, const char* prefix)
+{
+    uint64_t nWritten;
+    {
+        LOCK(cs_LastBlockFile);
+        if (nFile < 0 || (size_t)nFile >= vinfoBlockFile.size())
+            return 0;
+        const CBlockFileInfo& info = vinfoBlockFile[nFile];
+        nWritten = strcmp(prefix, "rev") == 0 ? info.nUndoSize : info.nSize;
+    }
+    boost::system::error_code ec;
+    uint64_t nOnDisk = fs::file_size(GetBlockPosFilename(CDiskBlockPos(nFile, 0), prefix), ec);
+    return ec ? 0 : std::min(nWritten, nOnDisk);
+}
+
+/**
+ * Find the record at pos in a mapped block or undo file. Both files store the
+ * message start and the size of a record in the eight bytes in front of it;
+ * nTrailing more bytes belonging to the record follow it, like the checksum of
+ * undo data. Returns false if -blockmmap is off, the file can't be mapped or
+ * the record isn't all there, leaving the read to OpenDiskFile.
+ */
+static bool MapDiskRecord(const CDiskBlockPos& pos, const char* prefix, uint64_t nTrailing,
+                          Span<const unsigned char>& record, std::shared_ptr<const CMappedBlockFile>& map)
+{
+    if (!fBlockMmap || pos.IsNull() || pos.nPos < 8)
+        return false;
+    const uint64_t nAvailable = GetDiskFileAvailable(pos.nFile, prefix);
+    if (pos.nPos > nAvailable)
+        return false;
+    map = blockFileMaps.Get(pos.nFile, prefix, pos.nPos);
+    if (!map)
+        return false;
+    uint64_t nEnd = (uint64_t)pos.nPos + ReadLE32(map->data() + pos.nPos - 4) + nTrailing;
+    if (nEnd > nAvailable)
+        return false;
+    if (nEnd > map->size()) {
+        map = blockFileMaps.Get(pos.nFile, prefix, nEnd);
+        if (!map)
+            return false;
+    }
+    record = Span<const unsigned char>(map->data() + pos.nPos, nEnd - pos.nPos);
+    return true;
+}
+
 static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart)
 {
     // Open history file to append
@@ -1132,10 +1299,24 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+static bool ReadBlockFromDiskNoPoW(CBlock& block, const CDiskBlockPos& pos)
 {
     block.SetNull();
 
+    // Deserialize straight from the mapped block file if possible
+    std::shared_ptr<const CMappedBlockFile> map;
+    Span<const unsigned char> record;
+    if (MapDiskRecord(pos, "blk", 0, record, map)) {
+        try {
+            SpanReader filein(SER_DISK, CLIENT_VERSION, record);
+            filein >> block;
+        }
+        catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+        return true;
+    }
+
     // Open history file to read
     CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull())
@@ -1149,6 +1330,14 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+{
+    if (!ReadBlockFromDiskNoPoW(block, pos))
+        return false;
+
     unsigned int profile = 0x3;
     if (block.GetBlockTime() >= consensusParams.nNeoScryptFork)
         profile = 0x0;
@@ -1162,7 +1351,10 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
 
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
-    if (!ReadBlockFromDisk(block, pindex->GetBlockPos(), consensusParams))
+    // The header's proof of work was checked when it entered mapBlockIndex, and
+    // the hash comparison below ties the data on disk to that header, so skip
+    // recomputing the (expensive) NeoScrypt hash here.
+    if (!ReadBlockFromDiskNoPoW(block, pindex->GetBlockPos()))
         return false;
 
     if (block.GetHash() != pindex->GetBlockHash()) {
@@ -1219,6 +1411,27 @@ bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CBlockIndex* pindex
     return ReadRawBlockFromDisk(block, block_pos, message_start);
 }
 
+bool ReadRawBlockFromDisk(Span<const uint8_t>& block, std::shared_ptr<const CMappedBlockFile>& map, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& message_start)
+{
+    CDiskBlockPos block_pos;
+    {
+        LOCK(cs_main);
+        block_pos = pindex->GetBlockPos();
+    }
+
+    if (!MapDiskRecord(block_pos, "blk", 0, block, map))
+        return false;
+
+    const unsigned char* blk_start = block.data() - 8;
+    if (memcmp(blk_start, message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+        return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, block_pos.ToString(),
+                HexStr(blk_start, blk_start + CMessageHeader::MESSAGE_START_SIZE),
+                HexStr(message_start, message_start + CMessageHeader::MESSAGE_START_SIZE));
+    }
+
+    return true;
+}
+
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
 {
     int halvings = 0;
@@ -1570,21 +1783,14 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
-{
-    CDiskBlockPos pos = pindex->GetUndoPos();
-    if (pos.IsNull()) {
-        return error("%s: no undo data available", __func__);
-    }
-
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("%s: OpenUndoFile failed", __func__);
+} // namespace
 
+template <typename Stream>
+static bool UndoReadFromStream(Stream& filein, CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
     // Read block
     uint256 hashChecksum;
-    CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
+    CHashVerifier<Stream> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
     try {
         verifier << pindex->pprev->GetBlockHash();
         verifier >> blockundo;
@@ -1601,6 +1807,32 @@ static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
     return true;
 }
 
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    CDiskBlockPos pos = pindex->GetUndoPos();
+    if (pos.IsNull()) {
+        return error("%s: no undo data available", __func__);
+    }
+
+    // Deserialize straight from the mapped undo file if possible
+    std::shared_ptr<const CMappedBlockFile> map;
+    Span<const unsigned char> record;
+    if (MapDiskRecord(pos, "rev", sizeof(uint256), record, map)) {
+        SpanReader filein(SER_DISK, CLIENT_VERSION, record);
+        return UndoReadFromStream(filein, blockundo, pindex);
+    }
+
+    // Open history file to read
+    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: OpenUndoFile failed", __func__);
+
+    return UndoReadFromStream(filein, blockundo, pindex);
+}
+
+
+namespace {
+
 /** Abort with a message */
 static bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
 {
@@ -1721,6 +1953,9 @@ void static FlushBlockFile(bool fFinalize = false)
     CDiskBlockPos posOld(nLastBlockFile, 0);
     bool status = true;
 
+    if (fFinalize)
+        blockFileMaps.Invalidate(nLastBlockFile);
+
     FILE *fileOld = OpenBlockFile(posOld);
     if (fileOld) {
         if (fFinalize)
@@ -1753,6 +1988,7 @@ static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, CValidationState&
             return error("ConnectBlock(): FindUndoPos failed");
         if (!UndoWriteToDisk(blockundo, _pos, pindex->pprev->GetBlockHash(), chainparams.MessageStart()))
             return AbortNode(state, "Failed to write undo data");
+        blockFileMaps.Invalidate(_pos.nFile, "rev");
 
         // update nUndoPos in block index
         pindex->nUndoPos = _pos.nPos;
@@ -1770,6 +2006,206 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+namespace {
+/**
+ * Cache of block hashes whose proof of work has been verified, so that a
+ * header is NeoScrypt-hashed once on its way through header sync, CheckBlock,
+ * compact block reconstruction and AcceptBlockHeader. Headers that already
+ * made it into mapBlockIndex need no entry: being indexed implies this check
+ * passed.
+ */
+static CSaltedCuckooCache powCache;
+
+//! Entries are SHA256(nonce || block hash)
+uint256 PoWCacheEntry(const uint256& hash)
+{
+    uint256 entry;
+    powCache.GetHasher().Write(hash.begin(), 32).Finalize(entry.begin());
+    return entry;
+}
+} // namespace
+
+void InitPoWCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-powcache", DEFAULT_POW_CACHE_SIZE)), MAX_POW_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = powCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for proof-of-work cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+/**
+ * Closure representing the proof-of-work check of a few headers sharing one
+ * NeoScrypt profile. They are hashed together in parallel lanes, and the
+ * outcome for each header is written through its own result pointer.
+ */
+class CPoWCheck
+{
+private:
+    std::vector<const CBlockHeader*> vHeaders;
+    std::vector<unsigned char*> vResults;
+    unsigned int nProfile;
+    const Consensus::Params* pconsensusParams;
+
+public:
+    CPoWCheck(): nProfile(0), pconsensusParams(nullptr) {}
+    CPoWCheck(unsigned int nProfileIn, const Consensus::Params& consensusParams) :
+        nProfile(nProfileIn), pconsensusParams(&consensusParams) { }
+
+    void Add(const CBlockHeader* pheader, unsigned char* pfValid)
+    {
+        vHeaders.push_back(pheader);
+        vResults.push_back(pfValid);
+    }
+
+    size_t size() const { return vHeaders.size(); }
+    unsigned int GetProfile() const { return nProfile; }
+
+    bool operator()()
+    {
+        std::vector<uint256> vHashes = GetPoWHashes(vHeaders, nProfile);
+        bool fAllOk = true;
+        for (size_t i = 0; i < vHeaders.size(); i++) {
+            *vResults[i] = CheckProofOfWork(vHashes[i], vHeaders[i]->nBits, *pconsensusParams);
+            if (*vResults[i]) {
+                powCache.Insert(PoWCacheEntry(vHeaders[i]->GetHash()));
+            } else {
+                fAllOk = false;
+            }
+        }
+        return fAllOk;
+    }
+
+    void swap(CPoWCheck& check)
+    {
+        vHeaders.swap(check.vHeaders);
+        vResults.swap(check.vResults);
+        std::swap(nProfile, check.nProfile);
+        std::swap(pconsensusParams, check.pconsensusParams);
+    }
+};
+
+/** Number of headers hashed together by one CPoWCheck (the widest NeoScrypt kernel) */
+static const size_t POW_CHECK_BATCH = 8;
+/** Most headers hashed before checking whether any of them failed */
+static const size_t POW_CHECK_ROUND = 4 * POW_CHECK_BATCH;
+
+static CCheckQueue<CPoWCheck> powcheckqueue(4);
+
+void ThreadPoWCheck() {
+    RenameThread("bitcoin-powch");
+    powcheckqueue.Thread();
+}
+
+/**
+ * Verify the proof of work of the headers not yet in mapBlockIndex without
+ * holding cs_main, spreading the work over the script check threads.
+ * vPoWValid[i] is set for every header that passed; the others are left for
+ * AcceptBlockHeader to check (and reject) serially.
+ *
+ * Bogus headers must not cost more NeoScrypt hashes here than they would in
+ * AcceptBlockHeader, which stops at the first one. So only headers that
+ * connect to the index (directly or through an earlier header of the batch)
+ * and claim a target in range, the required one where the parent is
+ * indexed, get hashed at all. The first of them is hashed on its own, the
+ * rest in rounds of POW_CHECK_ROUND, and hashing stops after a round with a
+ * failure.
+ */
+static void CheckHeadersPoW(const std::vector<CBlockHeader>& headers, std::vector<unsigned char>& vPoWValid, const Consensus::Params& consensusParams)
+{
+    vPoWValid.assign(headers.size(), 0);
+
+    std::vector<size_t> vUnknown;
+    {
+        LOCK(cs_main);
+        std::set<uint256> setQueued;
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
+            const uint256 hash = header.GetHash();
+            if (LookupBlockIndex(hash))
+                continue;
+            // Any hash meets a valid target, so this is just the range check on nBits
+            if (!CheckProofOfWork(uint256(), header.nBits, consensusParams))
+                continue;
+            const CBlockIndex* pindexPrev = LookupBlockIndex(header.hashPrevBlock);
+            if (pindexPrev) {
+                if (pindexPrev->nStatus & BLOCK_FAILED_MASK)
+                    continue;
+                if (header.nBits != GetNextWorkRequired(pindexPrev, &header, consensusParams))
+                    continue;
+            } else if (!setQueued.count(header.hashPrevBlock)) {
+                continue;
+            }
+            setQueued.insert(hash);
+            vUnknown.push_back(i);
+        }
+    }
+
+    size_t nNext = 0;
+    while (nNext < vUnknown.size()) {
+        std::vector<CPoWCheck> vChecks;
+        const size_t nRoundEnd = std::min(vUnknown.size(), nNext == 0 ? 1 : nNext + POW_CHECK_ROUND);
+        for (; nNext < nRoundEnd; nNext++) {
+            const size_t i = vUnknown[nNext];
+            unsigned int nProfile = GetPoWProfile(headers[i], consensusParams);
+            if (vChecks.empty() || vChecks.back().size() >= POW_CHECK_BATCH || vChecks.back().GetProfile() != nProfile)
+                vChecks.emplace_back(nProfile, consensusParams);
+            vChecks.back().Add(&headers[i], &vPoWValid[i]);
+        }
+
+        bool fAllOk = true;
+        if (nScriptCheckThreads && vChecks.size() > 1) {
+            CCheckQueueControl<CPoWCheck> control(&powcheckqueue);
+            control.Add(vChecks);
+            fAllOk = control.Wait();
+        } else {
+            for (CPoWCheck& check : vChecks) {
+                if (!check()) {
+                    fAllOk = false;
+                    break;
+                }
+            }
+        }
+        if (!fAllOk)
+            break;
+    }
+}
+
+/**
+ * Closure representing the context-free checks of one block read from an
+ * external file, run by CheckBlock with the proof of work normally found in
+ * powCache already.
+ */
+class CBlockCheck
+{
+private:
+    std::shared_ptr<const CBlock> pblock;
+    const Consensus::Params* pconsensusParams;
+
+public:
+    CBlockCheck(): pconsensusParams(nullptr) {}
+    CBlockCheck(std::shared_ptr<const CBlock> pblockIn, const Consensus::Params& consensusParams) :
+        pblock(std::move(pblockIn)), pconsensusParams(&consensusParams) { }
+
+    bool operator()()
+    {
+        CValidationState state;
+        return CheckBlock(*pblock, state, *pconsensusParams);
+    }
+
+    void swap(CBlockCheck& check)
+    {
+        pblock.swap(check.pblock);
+        std::swap(pconsensusParams, check.pconsensusParams);
+    }
+};
+
+static CCheckQueue<CBlockCheck> blockcheckqueue(1);
+
+void ThreadBlockCheck() {
+    RenameThread("bitcoin-blkch");
+    blockcheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -1904,7 +2340,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // is enforced in ContextualCheckBlockHeader(); we wouldn't want to
     // re-enforce that rule here (at least until we make it impossible for
     // GetAdjustedTime() to go backward).
-    if (!CheckBlock(block, state, chainparams.GetConsensus(), !fJustCheck, !fJustCheck)) {
+    // The proof of work is not checked again: pindex is in mapBlockIndex, so
+    // it was verified when the header was accepted.
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), false, !fJustCheck)) {
         if (state.CorruptionPossible()) {
             // We don't write down blocks to disk if they may have been
             // corrupted, so this should be impossible unless we're having hardware
@@ -3124,15 +3562,18 @@ static bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos,
     return true;
 }
 
+
 static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
 {
-    unsigned int profile = 0x3;
-    if (block.GetBlockTime() >= consensusParams.nNeoScryptFork)
-        profile = 0x0;
-
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetPoWHash(profile), block.nBits, consensusParams))
-        return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
+    if (fCheckPOW) {
+        uint256 entry = PoWCacheEntry(block.GetHash());
+        if (!powCache.Contains(entry)) {
+            if (!CheckProofOfWork(block.GetPoWHash(GetPoWProfile(block, consensusParams)), block.nBits, consensusParams))
+                return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
+            powCache.Insert(entry);
+        }
+    }
 
     return true;
 }
@@ -3430,7 +3871,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3448,7 +3889,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), fCheckPOW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3495,11 +3936,18 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+
+    // Proof of work is context free, so check it for the whole batch before
+    // taking cs_main and keep only the contextual checks serialized.
+    std::vector<unsigned char> vPoWValid;
+    CheckHeadersPoW(headers, vPoWValid, chainparams.GetConsensus());
+
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, !vPoWValid[i])) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -3527,6 +3975,7 @@ static CDiskBlockPos SaveBlockToDisk(const CBlock& block, int nHeight, const CCh
             AbortNode("Failed to write block");
             return CDiskBlockPos();
         }
+        blockFileMaps.Invalidate(blockPos.nFile, "blk");
     }
     return blockPos;
 }
@@ -3743,6 +4192,7 @@ void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
+        blockFileMaps.Invalidate(*it);
         fs::remove(GetBlockPosFilename(pos, "blk"));
         fs::remove(GetBlockPosFilename(pos, "rev"));
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -4112,8 +4562,8 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         // check level 0: read from disk
         if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-        // check level 1: verify block validity
-        if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams.GetConsensus()))
+        // check level 1: verify block validity (the header was verified when it was indexed)
+        if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams.GetConsensus(), false))
             return error("%s: *** found bad block at %d, hash=%s (%s)\n", __func__,
                          pindex->nHeight, pindex->GetBlockHash().ToString(), FormatStateMessage(state));
         // check level 2: verify undo validity
@@ -4455,20 +4905,133 @@ bool LoadGenesisBlock(const CChainParams& chainparams)
     return g_chainstate.LoadGenesisBlock(chainparams);
 }
 
-bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
+/** Blocks read from an external file before they are handed over for checking as one batch */
+static const unsigned int IMPORT_BATCH_BLOCKS = 256;
+/** Serialized size at which a batch is handed over regardless of its block count */
+static const uint64_t IMPORT_BATCH_BYTES = 4 * MAX_BLOCK_SERIALIZED_SIZE;
+/** Checked batches waiting for AcceptBlock, bounding how far the reader runs ahead */
+static const size_t MAX_IMPORT_BATCHES_QUEUED = 2;
+
+/** A block read from an external file, with its position when importing our own block files */
+struct CImportedBlock
 {
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
-    int64_t nStart = GetTimeMillis();
+    std::shared_ptr<CBlock> pblock;
+    CDiskBlockPos pos;
+    bool fHavePos;
+};
 
-    int nLoaded = 0;
+/**
+ * Hand-over of checked batches from the thread reading an external block file
+ * to the thread accepting them, so that reading and checking the next batch
+ * overlaps with AcceptBlock on the current one.
+ */
+class CImportQueue
+{
+private:
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    std::deque<std::vector<CImportedBlock>> queue;
+    //! The reader has nothing more to push
+    bool fDone = false;
+    //! The accepting thread won't pop anymore
+    bool fStopped = false;
+
+public:
+    //! Queue a batch, waiting for room. Returns false if the batch won't be accepted.
+    bool Push(std::vector<CImportedBlock>&& vBlocks)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!fStopped && queue.size() >= MAX_IMPORT_BATCHES_QUEUED)
+            cond.wait(lock);
+        if (fStopped)
+            return false;
+        queue.push_back(std::move(vBlocks));
+        cond.notify_all();
+        return true;
+    }
+
+    //! Take the next batch, waiting for the reader. Returns false once it's done and all batches were taken.
+    bool Pop(std::vector<CImportedBlock>& vBlocks)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!fDone && queue.empty())
+            cond.wait(lock);
+        if (queue.empty())
+            return false;
+        vBlocks = std::move(queue.front());
+        queue.pop_front();
+        cond.notify_all();
+        return true;
+    }
+
+    void SetDone()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fDone = true;
+        cond.notify_all();
+    }
+
+    void Stop()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fStopped = true;
+        cond.notify_all();
+    }
+
+    bool IsStopped()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        return fStopped;
+    }
+};
+
+/**
+ * Run the context-free checks of a batch of imported blocks over the check
+ * threads: proof of work first, hashed in NeoScrypt lanes and remembered in
+ * powCache, then CheckBlock, which marks the blocks that pass as fChecked so
+ * that AcceptBlock skips it. Blocks that fail are left for AcceptBlock to
+ * reject serially, as are blocks already in mapBlockIndex.
+ */
+static void CheckImportedBlocks(const std::vector<CImportedBlock>& vBlocks, const Consensus::Params& consensusParams)
+{
+    std::vector<CBlockHeader> headers;
+    headers.reserve(vBlocks.size());
+    for (const CImportedBlock& entry : vBlocks)
+        headers.push_back(entry.pblock->GetBlockHeader());
+
+    std::vector<unsigned char> vPoWValid;
+    CheckHeadersPoW(headers, vPoWValid, consensusParams);
+
+    std::vector<CBlockCheck> vChecks;
+    for (size_t i = 0; i < vBlocks.size(); i++) {
+        if (vPoWValid[i])
+            vChecks.emplace_back(vBlocks[i].pblock, consensusParams);
+    }
+
+    if (nScriptCheckThreads && vChecks.size() > 1) {
+        CCheckQueueControl<CBlockCheck> control(&blockcheckqueue);
+        control.Add(vChecks);
+        control.Wait();
+    } else {
+        for (CBlockCheck& check : vChecks)
+            check();
+    }
+}
+
+/**
+ * Scan an external block file for blocks and hand them over to the accepting
+ * thread in checked batches, until the end of the file or until the accepting
+ * thread stops the queue. Blocks are deserialized here rather than on the
+ * check threads, so that a record that fails to parse is rescanned from just
+ * after its message start, as before.
+ */
+static void ReadExternalBlockFile(const CChainParams& chainparams, CBufferedFile& blkdat, const CDiskBlockPos* pposFile, CImportQueue& queue)
+{
+    std::vector<CImportedBlock> vBatch;
+    uint64_t nBatchBytes = 0;
     try {
-        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
-        CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
         uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
-            boost::this_thread::interruption_point();
-
+        while (!blkdat.eof() && !queue.IsStopped()) {
             blkdat.SetPos(nRewind);
             nRewind++; // start one byte further next time, in case of failure
             blkdat.SetLimit(); // remove former limit
@@ -4492,86 +5055,161 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
             try {
                 // read block
                 uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos);
                 std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
+                blkdat >> *pblock;
                 nRewind = blkdat.GetPos();
 
-                uint256 hash = block.GetHash();
-                {
-                    LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
-                    if (hash != chainparams.GetConsensus().hashGenesisBlock && !LookupBlockIndex(block.hashPrevBlock)) {
-                        LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                                block.hashPrevBlock.ToString());
-                        if (dbp)
-                            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                        continue;
-                    }
+                CImportedBlock entry;
+                entry.pblock = std::move(pblock);
+                entry.fHavePos = pposFile != nullptr;
+                if (pposFile)
+                    entry.pos = CDiskBlockPos(pposFile->nFile, nBlockPos);
+                vBatch.push_back(std::move(entry));
+                nBatchBytes += nSize;
+            } catch (const std::exception& e) {
+                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            }
 
-                    // process in case the block isn't known yet
-                    CBlockIndex* pindex = LookupBlockIndex(hash);
-                    if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
-                      CValidationState state;
-                      if (g_chainstate.AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr)) {
-                          nLoaded++;
-                      }
-                      if (state.IsError()) {
-                          break;
-                      }
-                    } else if (hash != chainparams.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
-                      LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
-                    }
-                }
+            if (vBatch.size() >= IMPORT_BATCH_BLOCKS || nBatchBytes >= IMPORT_BATCH_BYTES) {
+                CheckImportedBlocks(vBatch, chainparams.GetConsensus());
+                if (!queue.Push(std::move(vBatch)))
+                    break;
+                vBatch.clear();
+                nBatchBytes = 0;
+            }
+        }
+        if (!vBatch.empty()) {
+            CheckImportedBlocks(vBatch, chainparams.GetConsensus());
+            queue.Push(std::move(vBatch));
+        }
+    } catch (const std::runtime_error& e) {
+        AbortNode(std::string("System error: ") + e.what());
+    }
+    queue.SetDone();
+}
 
-                // Activate the genesis block so normal node progress can continue
-                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
-                    CValidationState state;
-                    if (!ActivateBestChain(state, chainparams)) {
-                        break;
-                    }
+/**
+ * Accept one imported block, then the blocks read earlier that were waiting
+ * for it as their parent. Returns false when the import has to stop.
+ */
+static bool ProcessImportedBlock(const CChainParams& chainparams, const CImportedBlock& entry, std::multimap<uint256, CDiskBlockPos>& mapBlocksUnknownParent, int& nLoaded)
+{
+    const std::shared_ptr<CBlock>& pblock = entry.pblock;
+    const CBlock& block = *pblock;
+    const CDiskBlockPos* dbp = entry.fHavePos ? &entry.pos : nullptr;
+
+    uint256 hash = block.GetHash();
+    {
+        LOCK(cs_main);
+        // detect out of order blocks, and store them for later
+        if (hash != chainparams.GetConsensus().hashGenesisBlock && !LookupBlockIndex(block.hashPrevBlock)) {
+            LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                    block.hashPrevBlock.ToString());
+            if (dbp)
+                mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+            return true;
+        }
+
+        // process in case the block isn't known yet
+        CBlockIndex* pindex = LookupBlockIndex(hash);
+        if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+          CValidationState state;
+          if (g_chainstate.AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr)) {
+              nLoaded++;
+          }
+          if (state.IsError()) {
+              return false;
+          }
+        } else if (hash != chainparams.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+          LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
+        }
+    }
+
+    // Activate the genesis block so normal node progress can continue
+    if (hash == chainparams.GetConsensus().hashGenesisBlock) {
+        CValidationState state;
+        if (!ActivateBestChain(state, chainparams)) {
+            return false;
+        }
+    }
+
+    NotifyHeaderTip();
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
+            {
+                LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                CValidationState dummy;
+                if (g_chainstate.AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr))
+                {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
                 }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+            NotifyHeaderTip();
+        }
+    }
+    return true;
+}
 
-                NotifyHeaderTip();
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
-                        {
-                            LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            CValidationState dummy;
-                            if (g_chainstate.AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr))
-                            {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip();
+bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
+{
+    // Map of disk positions for blocks with unknown parent (only used for reindex)
+    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+    int64_t nStart = GetTimeMillis();
+
+    int nLoaded = 0;
+    // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
+    CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
+    const CDiskBlockPos posFile = dbp ? *dbp : CDiskBlockPos();
+
+    // Blocks are read and checked on a separate thread, and accepted here in file order.
+    CImportQueue queue;
+    boost::thread reader([&] {
+        RenameThread("bitcoin-loadread");
+        ReadExternalBlockFile(chainparams, blkdat, dbp ? &posFile : nullptr, queue);
+    });
+    try {
+        std::vector<CImportedBlock> vBatch;
+        bool fContinue = true;
+        while (fContinue && queue.Pop(vBatch)) {
+            for (const CImportedBlock& entry : vBatch) {
+                boost::this_thread::interruption_point();
+                try {
+                    if (dbp)
+                        *dbp = entry.pos;
+                    if (!ProcessImportedBlock(chainparams, entry, mapBlocksUnknownParent, nLoaded)) {
+                        fContinue = false;
+                        break;
                     }
+                } catch (const std::exception& e) {
+                    LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
                 }
-            } catch (const std::exception& e) {
-                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
         }
-    } catch (const std::runtime_error& e) {
-        AbortNode(std::string("System error: ") + e.what());
+    } catch (...) {
+        queue.Stop();
+        reader.join();
+        throw;
     }
+    queue.Stop();
+    reader.join();
+
     if (nLoaded > 0)
         LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
     return nLoaded > 0;
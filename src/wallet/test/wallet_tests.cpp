@@ -11,6 +11,7 @@
 #include <vector>
 
 #include <consensus/validation.h>
+#include <privatesend.h>
 #include <rpc/server.h>
 #include <test/test_bitcoin.h>
 #include <validation.h>
@@ -418,4 +419,101 @@ BOOST_FIXTURE_TEST_CASE(dummy_input_size_test, TestChain100Setup)
     BOOST_CHECK_EQUAL(CalculateNestedKeyhashInputSize(true), DUMMY_NESTED_P2WPKH_INPUT_SIZE);
 }
 
+class DenominatedCoinsTestingSetup : public ListCoinsTestingSetup
+{
+public:
+    DenominatedCoinsTestingSetup()
+    {
+        CPrivateSend::InitStandardDenominations();
+    }
+
+    CMutableTransaction MakeTx(const std::vector<COutPoint>& vPrevouts, const std::vector<CAmount>& vAmounts)
+    {
+        CMutableTransaction mtx;
+        for (const COutPoint& prevout : vPrevouts) {
+            mtx.vin.emplace_back(prevout);
+        }
+        for (const CAmount& nAmount : vAmounts) {
+            mtx.vout.emplace_back(nAmount, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+        }
+        return mtx;
+    }
+
+    //! Add a transaction to the wallet as if it were in the tip, or unconfirmed
+    uint256 AddTx(const CMutableTransaction& mtx, bool fConfirmed = true)
+    {
+        LOCK2(cs_main, wallet->cs_wallet);
+        CWalletTx wtx(wallet.get(), MakeTransactionRef(mtx));
+        if (fConfirmed) {
+            wtx.SetMerkleBranch(chainActive.Tip(), 0);
+        }
+        BOOST_CHECK(wallet->AddToWallet(wtx));
+        return wtx.GetHash();
+    }
+
+    //! Available coins of nCoinType, by outpoint
+    std::set<COutPoint> ListAvailable(AvailableCoinsType nCoinType)
+    {
+        LOCK2(cs_main, wallet->cs_wallet);
+        std::vector<COutput> vCoins;
+        wallet->AvailableCoins(vCoins, false, nullptr, 1, MAX_MONEY, MAX_MONEY, 0, 0, 9999999, nCoinType);
+        std::set<COutPoint> setCoins;
+        for (const COutput& out : vCoins) {
+            setCoins.emplace(out.tx->GetHash(), out.i);
+        }
+        return setCoins;
+    }
+
+    //! What a scan of the whole wallet finds denominated, ONLY_DENOMINATED has to agree with it
+    std::set<COutPoint> ListDenominatedFullScan()
+    {
+        LOCK2(cs_main, wallet->cs_wallet);
+        std::set<COutPoint> setCoins;
+        for (const COutPoint& outpoint : ListAvailable(ALL_COINS)) {
+            if (CPrivateSend::IsDenominatedAmount(wallet->mapWallet.at(outpoint.hash).tx->vout[outpoint.n].nValue)) {
+                setCoins.insert(outpoint);
+            }
+        }
+        return setCoins;
+    }
+
+    int GetRounds(const COutPoint& outpoint)
+    {
+        LOCK(wallet->cs_wallet);
+        return wallet->GetRealOutpointPrivateSendRounds(outpoint, 0);
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(DenominatedCoins, DenominatedCoinsTestingSetup)
+{
+    const std::vector<CAmount> vecDenoms = CPrivateSend::GetStandardDenominations();
+    const CAmount nDenom = vecDenoms.back();
+    BOOST_CHECK(ListAvailable(ONLY_DENOMINATED).empty());
+
+    // a mixing transaction whose parent isn't in the wallet yet, and one with change
+    CMutableTransaction parent = MakeTx({COutPoint(uint256S("01"), 0)}, {nDenom, nDenom});
+    uint256 hashMix = AddTx(MakeTx({COutPoint(parent.GetHash(), 0), COutPoint(parent.GetHash(), 1)}, {nDenom, nDenom}));
+    uint256 hashChange = AddTx(MakeTx({COutPoint(uint256S("02"), 0)}, {vecDenoms[vecDenoms.size() - 2], 5 * COIN}));
+    BOOST_CHECK(ListAvailable(ONLY_DENOMINATED) == std::set<COutPoint>({COutPoint(hashMix, 0), COutPoint(hashMix, 1), COutPoint(hashChange, 0)}));
+    BOOST_CHECK(ListAvailable(ONLY_DENOMINATED) == ListDenominatedFullScan());
+    BOOST_CHECK_EQUAL(GetRounds(COutPoint(hashMix, 0)), 0);
+    BOOST_CHECK_EQUAL(GetRounds(COutPoint(hashChange, 0)), 0);
+    BOOST_CHECK_EQUAL(GetRounds(COutPoint(hashChange, 1)), -2);
+
+    // the parent arriving adds a round to the cached count of its child, its own outputs are spent already
+    uint256 hashParent = AddTx(parent);
+    BOOST_CHECK_EQUAL(GetRounds(COutPoint(hashMix, 0)), 1);
+    BOOST_CHECK_EQUAL(GetRounds(COutPoint(hashParent, 0)), 0);
+    BOOST_CHECK(!ListAvailable(ONLY_DENOMINATED).count(COutPoint(hashParent, 0)));
+    BOOST_CHECK(ListAvailable(ONLY_DENOMINATED) == ListDenominatedFullScan());
+
+    // spending takes a coin out, abandoning the spend puts it back
+    uint256 hashSpend = AddTx(MakeTx({COutPoint(hashMix, 0)}, {5 * COIN}), false);
+    BOOST_CHECK(!ListAvailable(ONLY_DENOMINATED).count(COutPoint(hashMix, 0)));
+    BOOST_CHECK(ListAvailable(ONLY_DENOMINATED) == ListDenominatedFullScan());
+    BOOST_CHECK(wallet->AbandonTransaction(hashSpend));
+    BOOST_CHECK(ListAvailable(ONLY_DENOMINATED).count(COutPoint(hashMix, 0)));
+    BOOST_CHECK(ListAvailable(ONLY_DENOMINATED) == ListDenominatedFullScan());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -683,6 +683,17 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
     setWalletUTXO.erase(outpoint);
 
+    auto itPrev = mapWallet.find(outpoint.hash);
+    if (itPrev != mapWallet.end() && outpoint.n < itPrev->second.tx->vout.size()) {
+        auto itDenom = mapWalletDenominatedUTXO.find(itPrev->second.tx->vout[outpoint.n].nValue);
+        if (itDenom != mapWalletDenominatedUTXO.end()) {
+            itDenom->second.erase(outpoint);
+            if (itDenom->second.empty()) {
+                mapWalletDenominatedUTXO.erase(itDenom);
+            }
+        }
+    }
+
     setLockedCoins.erase(outpoint);
 
     std::pair<TxSpends::iterator, TxSpends::iterator> range;
@@ -690,6 +701,17 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
     SyncMetaData(range);
 }
 
+void CWallet::AddToDenominatedUTXO(const CWalletTx& wtx)
+{
+    const uint256& hash = wtx.GetHash();
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        const CTxOut& txout = wtx.tx->vout[i];
+        if (CPrivateSend::IsDenominatedAmount(txout.nValue) && IsMine(txout) && !IsSpent(hash, i)) {
+            mapWalletDenominatedUTXO[txout.nValue].insert(COutPoint(hash, i));
+        }
+    }
+}
+
 
 void CWallet::AddToSpends(const uint256& wtxid)
 {
@@ -1069,6 +1091,13 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
     // Break debit/credit balance caches:
     wtx.MarkDirty();
 
+    // Outputs may have become ours since, or unspent again
+    AddToDenominatedUTXO(wtx);
+
+    // Children that arrived first had their rounds counted without this one
+    if (fInsertedNew)
+        InvalidatePrivateSendRounds(hash);
+
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
 
@@ -1181,6 +1210,8 @@ void CWallet::MarkInputsDirty(const CTransactionRef& tx)
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            // spent outputs stay in the index until selected and skipped, outputs spent by a conflicted tx come back
+            AddToDenominatedUTXO(it->second);
         }
     }
 }
@@ -1490,7 +1521,7 @@ CAmount CWallet::GetDebit(const CTransaction& tx, const isminefilter& filter) co
 // Recursively determine the rounds of a given input (How deep is the PrivateSend chain for a given input)
 int CWallet::GetRealOutpointPrivateSendRounds(const COutPoint& outpoint, int nRounds) const
 {
-    static std::map<uint256, CMutableTransaction> mDenomWtxes;
+    AssertLockHeld(cs_wallet);
 
     if(nRounds >= MAX_PRIVATESEND_ROUNDS) {
         // there can only be MAX_PRIVATESEND_ROUNDS rounds max
@@ -1503,14 +1534,14 @@ int CWallet::GetRealOutpointPrivateSendRounds(const COutPoint& outpoint, int nRo
     const CWalletTx* wtx = GetWalletTx(hash);
     if(wtx != NULL)
     {
-        std::map<uint256, CMutableTransaction>::const_iterator mdwi = mDenomWtxes.find(hash);
-        if (mdwi == mDenomWtxes.end()) {
+        auto ins = mapOutpointRoundsCache.emplace(outpoint, -10);
+        int& nRoundsCached = ins.first->second;
+        if (ins.second) {
             // not known yet, let's add it
             LogPrint(BCLog::PRIVATESEND, "%s INSERTING %s\n", __func__, hash.ToString());
-            mDenomWtxes[hash] = *wtx->tx;
-        } else if(mDenomWtxes[hash].vout[nout].nRounds != -10) {
+        } else if(nRoundsCached != -10) {
             // found and it's not an initial value, just return it
-            return mDenomWtxes[hash].vout[nout].nRounds;
+            return nRoundsCached;
         }
 
 
@@ -1522,16 +1553,16 @@ int CWallet::GetRealOutpointPrivateSendRounds(const COutPoint& outpoint, int nRo
         }
 
         if (CPrivateSend::IsCollateralAmount(wtx->tx->vout[nout].nValue)) {
-            mDenomWtxes[hash].vout[nout].nRounds = -3;
-            LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, mDenomWtxes[hash].vout[nout].nRounds);
-            return mDenomWtxes[hash].vout[nout].nRounds;
+            nRoundsCached = -3;
+            LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, nRoundsCached);
+            return nRoundsCached;
         }
 
         //make sure the final output is non-denominate
         if (!CPrivateSend::IsDenominatedAmount(wtx->tx->vout[nout].nValue)) { //NOT DENOM
-            mDenomWtxes[hash].vout[nout].nRounds = -2;
-            LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, mDenomWtxes[hash].vout[nout].nRounds);
-            return mDenomWtxes[hash].vout[nout].nRounds;
+            nRoundsCached = -2;
+            LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, nRoundsCached);
+            return nRoundsCached;
         }
 
         bool fAllDenoms = true;
@@ -1541,9 +1572,9 @@ int CWallet::GetRealOutpointPrivateSendRounds(const COutPoint& outpoint, int nRo
 
         // this one is denominated but there is another non-denominated output found in the same tx
         if (!fAllDenoms) {
-            mDenomWtxes[hash].vout[nout].nRounds = 0;
-            LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, mDenomWtxes[hash].vout[nout].nRounds);
-            return mDenomWtxes[hash].vout[nout].nRounds;
+            nRoundsCached = 0;
+            LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, nRoundsCached);
+            return nRoundsCached;
         }
 
         int nShortest = -10; // an initial value, should be no way to get this by calculations
@@ -1559,16 +1590,39 @@ int CWallet::GetRealOutpointPrivateSendRounds(const COutPoint& outpoint, int nRo
                 }
             }
         }
-        mDenomWtxes[hash].vout[nout].nRounds = fDenomFound
+        nRoundsCached = fDenomFound
                 ? (nShortest >= MAX_PRIVATESEND_ROUNDS - 1 ? MAX_PRIVATESEND_ROUNDS : nShortest + 1) // good, we a +1 to the shortest one but only MAX_PRIVATESEND_ROUNDS rounds max allowed
                 : 0;            // too bad, we are the fist one in that chain
-        LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, mDenomWtxes[hash].vout[nout].nRounds);
-        return mDenomWtxes[hash].vout[nout].nRounds;
+        LogPrint(BCLog::PRIVATESEND, "%s UPDATED   %s %3d %3d\n", __func__, hash.ToString(), nout, nRoundsCached);
+        return nRoundsCached;
     }
 
     return nRounds - 1;
 }
 
+void CWallet::InvalidatePrivateSendRounds(const uint256& hash)
+{
+    AssertLockHeld(cs_wallet);
+
+    // rounds look back at most MAX_PRIVATESEND_ROUNDS transactions, so a change doesn't reach further down
+    std::set<uint256> setSeen;
+    std::vector<uint256> vHashes{hash};
+    for (int nDepth = 0; nDepth <= MAX_PRIVATESEND_ROUNDS && !vHashes.empty() && !mapOutpointRoundsCache.empty(); nDepth++) {
+        std::vector<uint256> vChildren;
+        for (const uint256& txid : vHashes) {
+            if (!setSeen.insert(txid).second) continue;
+            auto it = mapOutpointRoundsCache.lower_bound(COutPoint(txid, 0));
+            while (it != mapOutpointRoundsCache.end() && it->first.hash == txid) {
+                it = mapOutpointRoundsCache.erase(it);
+            }
+            for (auto itSpend = mapTxSpends.lower_bound(COutPoint(txid, 0)); itSpend != mapTxSpends.end() && itSpend->first.hash == txid; ++itSpend) {
+                vChildren.push_back(itSpend->second);
+            }
+        }
+        vHashes.swap(vChildren);
+    }
+}
+
 // respect current settings
 int CWallet::GetOutpointPrivateSendRounds(const COutPoint& outpoint) const
 {
@@ -2457,11 +2511,13 @@ float CWallet::GetAverageAnonymizedRounds() const
     int nCount = 0;
 
     LOCK2(cs_main, cs_wallet);
-    for (const auto& outpoint : setWalletUTXO) {
-        if(!IsDenominated(outpoint)) continue;
+    for (const auto& denom : mapWalletDenominatedUTXO) {
+        for (const auto& outpoint : denom.second) {
+            if(IsSpent(outpoint.hash, outpoint.n)) continue;
 
-        nTotal += GetOutpointPrivateSendRounds(outpoint);
-        nCount++;
+            nTotal += GetOutpointPrivateSendRounds(outpoint);
+            nCount++;
+        }
     }
 
     if(nCount == 0) return 0;
@@ -2478,14 +2534,16 @@ CAmount CWallet::GetNormalizedAnonymizedBalance() const
     CAmount nTotal = 0;
 
     LOCK2(cs_main, cs_wallet);
-    for (const auto& outpoint : setWalletUTXO) {
-        std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end()) continue;
-        if (!IsDenominated(outpoint)) continue;
-        if (it->second.GetDepthInMainChain() < 0) continue;
+    for (const auto& denom : mapWalletDenominatedUTXO) {
+        for (const auto& outpoint : denom.second) {
+            std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
+            if (it == mapWallet.end()) continue;
+            if (IsSpent(outpoint.hash, outpoint.n)) continue;
+            if (it->second.GetDepthInMainChain() < 0) continue;
 
-        int nRounds = GetOutpointPrivateSendRounds(outpoint);
-        nTotal += it->second.tx->vout[outpoint.n].nValue * nRounds / privateSendClient.nPrivateSendRounds;
+            int nRounds = GetOutpointPrivateSendRounds(outpoint);
+            nTotal += denom.first * nRounds / privateSendClient.nPrivateSendRounds;
+        }
     }
 
     return nTotal;
@@ -2658,8 +2716,31 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
     vCoins.clear();
     CAmount nTotal = 0;
 
-    for (const auto& entry : mapWallet)
+    // denominated coins can only be in the transactions holding the indexed ones
+    std::vector<const std::pair<const uint256, CWalletTx>*> vpEntries;
+    if (nCoinType == ONLY_DENOMINATED) {
+        std::set<uint256> setDenominatedTxes;
+        for (const auto& denom : mapWalletDenominatedUTXO) {
+            for (const auto& outpoint : denom.second) {
+                setDenominatedTxes.insert(outpoint.hash);
+            }
+        }
+        for (const auto& hash : setDenominatedTxes) {
+            auto it = mapWallet.find(hash);
+            if (it != mapWallet.end()) {
+                vpEntries.push_back(&*it);
+            }
+        }
+    } else {
+        vpEntries.reserve(mapWallet.size());
+        for (const auto& entry : mapWallet) {
+            vpEntries.push_back(&entry);
+        }
+    }
+
+    for (const auto* pentry : vpEntries)
     {
+        const auto& entry = *pentry;
         const uint256& wtxid = entry.first;
         const CWalletTx* pcoin = &entry.second;
 
@@ -3103,12 +3184,13 @@ bool CWallet::SelectCoinsByDenominations(int nDenom, CAmount nValueMin, CAmount
 
             CTxIn txin = CTxIn(out.tx->GetHash(), out.i);
 
-            int nRounds = GetOutpointPrivateSendRounds(txin.prevout);
-            if(nRounds >= nPrivateSendRoundsMax) continue;
-            if(nRounds < nPrivateSendRoundsMin) continue;
-
             for (const auto& nBit : vecBits) {
                 if(out.tx->tx->vout[out.i].nValue == vecPrivateSendDenominations[nBit]) {
+                    // rounds are only worth looking up for the denominations asked for
+                    int nRounds = GetOutpointPrivateSendRounds(txin.prevout);
+                    if(nRounds >= nPrivateSendRoundsMax) break;
+                    if(nRounds < nPrivateSendRoundsMin) break;
+
                     nValueRet += out.tx->tx->vout[out.i].nValue;
                     vecTxDSInRet.push_back(CTxDSIn(txin, out.tx->tx->vout[out.i].scriptPubKey));
                     vCoinsRet.push_back(out);
@@ -3978,6 +4060,7 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
                     setWalletUTXO.insert(COutPoint(pair.first, i));
                 }
             }
+            AddToDenominatedUTXO(pair.second);
         }
     }
 
@@ -4001,6 +4084,7 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
         const auto& it = mapWallet.find(hash);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
         mapWallet.erase(it);
+        InvalidatePrivateSendRounds(hash);
     }
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE)
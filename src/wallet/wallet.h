@@ -736,6 +736,10 @@ private:
     mutable std::vector<CompactTallyItem> vecAnonymizableTallyCached;
     mutable bool fAnonymizableTallyCachedNonDenom = false;
     mutable std::vector<CompactTallyItem> vecAnonymizableTallyCachedNonDenom;
+    /// Results of GetRealOutpointPrivateSendRounds, -10 while being calculated
+    mutable std::map<COutPoint, int> mapOutpointRoundsCache;
+    /// Forget the cached rounds of the outputs of hash and of the wallet transactions spending them
+    void InvalidatePrivateSendRounds(const uint256& hash);
 
     /**
      * Used to keep track of spent outpoints, and
@@ -748,6 +752,9 @@ private:
     void AddToSpends(const uint256& wtxid);
 
     std::set<COutPoint> setWalletUTXO;
+    /// Denominated outputs of setWalletUTXO by denomination, so mixing doesn't have to look at the whole wallet
+    std::map<CAmount, std::set<COutPoint> > mapWalletDenominatedUTXO;
+    void AddToDenominatedUTXO(const CWalletTx& wtx);
 
     /**
      * Add a transaction to the wallet, or update it.  pIndex and posInBlock should